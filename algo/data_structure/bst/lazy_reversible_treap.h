@@ -1,3 +1,5 @@
+// requires node_pool.h
+
 struct LazyTag {
   LazyTag() {}
   void apply(const LazyTag& t) { d += t.d; }
@@ -28,6 +30,10 @@ struct LazyReversibleInfo {
 template <typename LazyReversibleInfo, typename LazyTag>
 class LazyReversibleTreap {
  public:
+  struct Node;
+  using Pool = NodePool<Node>;
+  using id_type = typename Pool::id_type;
+
   struct Node {
     LazyTag tag;
     LazyReversibleInfo val, sum;
@@ -35,7 +41,7 @@ class LazyReversibleTreap {
     priority_type priority;
     int size;
     bool is_rev;
-    Node *lson, *rson;
+    id_type lson, rson;
     static priority_type get_priority() {
       static std::mt19937_64 engine(
           std::chrono::steady_clock::now().time_since_epoch().count());
@@ -50,47 +56,60 @@ class LazyReversibleTreap {
           priority(get_priority()),
           size(1),
           is_rev(false),
-          lson(nullptr),
-          rson(nullptr) {}
+          lson(0),
+          rson(0) {}
 
-    static int getSize(Node* x) { return x ? x->size : 0; }
-    static LazyReversibleInfo getVal(Node* x) {
-      return x ? x->val : LazyReversibleInfo();
+    static int getSize(id_type x) { return x ? ref(x).size : 0; }
+    static LazyReversibleInfo getVal(id_type x) {
+      return x ? ref(x).val : LazyReversibleInfo();
     }
-    static LazyReversibleInfo getSum(Node* x) {
-      return x ? x->sum : LazyReversibleInfo();
+    static LazyReversibleInfo getSum(id_type x) {
+      return x ? ref(x).sum : LazyReversibleInfo();
     }
   };
 
-  LazyReversibleTreap(Node* rt = nullptr) : rt(rt) {}
-  LazyReversibleTreap(LazyReversibleInfo v) : rt(new Node(v)) {}
-  ~LazyReversibleTreap() {
-    std::function<void(Node*)> delete_node = [&](Node* rt) {
-      if (!rt) return;
-      delete_node(rt->lson);
-      delete_node(rt->rson);
-      delete rt;
-    };
-    delete_node(rt);
+  // all treaps of the same type share one pool, so nodes can move between
+  // them by extract/append. It is never destroyed, so that global treaps
+  // can still clear themselves at exit.
+  static Pool& pool() {
+    static Pool& p = *new Pool;
+    return p;
   }
 
+  LazyReversibleTreap() : rt(0) {}
+  LazyReversibleTreap(LazyReversibleInfo v) : rt(pool().allocate(v)) {}
+  // O(n)
+  LazyReversibleTreap(const std::vector<LazyReversibleInfo>& a)
+      : rt(pool().build(a.begin(), a.end(), pull)) {}
+  ~LazyReversibleTreap() { clear(); }
+
   LazyReversibleTreap& operator=(const LazyReversibleTreap& trp) = delete;
   LazyReversibleTreap(const LazyReversibleTreap& trp) = delete;
-  LazyReversibleTreap(LazyReversibleTreap&& trp) : rt(trp.rt) {
-    trp.rt = nullptr;
-  }
+  LazyReversibleTreap(LazyReversibleTreap&& trp) : rt(trp.rt) { trp.rt = 0; }
   LazyReversibleTreap& operator=(LazyReversibleTreap&& trp) {
+    if (this == &trp) return *this;
+    clear();
     rt = trp.rt;
-    trp.rt = nullptr;
+    trp.rt = 0;
     return *this;
   }
 
   int size() const { return Node::getSize(rt); }
 
+  // O(1) if this treap holds every node of the pool, O(size) otherwise.
+  void clear() {
+    if (size() == pool().size()) {
+      pool().reset();
+    } else {
+      release(rt);
+    }
+    rt = 0;
+  }
+
   // return [k,n), and current treap remains [0,k)
   LazyReversibleTreap extract(int k) {
     if (k >= Node::getSize(rt)) return LazyReversibleTreap();
-    Node* new_rt;
+    id_type new_rt;
     splitBySize(rt, rt, new_rt, k);
     return LazyReversibleTreap(new_rt);
   }
@@ -98,7 +117,7 @@ class LazyReversibleTreap {
   // append all info in trp, and trp will become empty
   LazyReversibleTreap& append(LazyReversibleTreap& trp) {
     rt = merge(rt, trp.rt);
-    trp.rt = nullptr;
+    trp.rt = 0;
     return *this;
   }
 
@@ -109,6 +128,15 @@ class LazyReversibleTreap {
     return *this;
   }
 
+  // insert a before k-th, O(m+logn)
+  LazyReversibleTreap& insertRange(int k,
+                                   const std::vector<LazyReversibleInfo>& a) {
+    LazyReversibleTreap middle(a);
+    LazyReversibleTreap suffix = extract(k);
+    append(middle).append(suffix);
+    return *this;
+  }
+
   LazyReversibleTreap& erase(int l, int r) {
     auto [middle, suffix] = split3(l, r + 1);
     append(suffix);
@@ -149,46 +177,45 @@ class LazyReversibleTreap {
 
   LazyReversibleInfo at(int k) const {
     assert(k < Node::getSize(rt));
-    for (Node* cur = rt;;) {
+    for (id_type cur = rt;;) {
       push(cur);
-      int size_with_lson = Node::getSize(cur->lson);
-      dbg(Node::getSize(cur), cur, cur->lson, cur->rson, size_with_lson, k);
-      if (k == size_with_lson) return cur->val;
+      int size_with_lson = Node::getSize(ref(cur).lson);
+      if (k == size_with_lson) return ref(cur).val;
       if (k < size_with_lson) {
-        cur = cur->lson;
+        cur = ref(cur).lson;
       } else {
         k -= size_with_lson + 1;
-        cur = cur->rson;
+        cur = ref(cur).rson;
       }
     }
   }
 
   LazyReversibleTreap& change(int k, LazyReversibleInfo v) {
     assert(k < Node::getSize(rt));
-    std::function<void(Node*, int)> change = [&](Node* rt, int k) {
+    std::function<void(id_type, int)> change = [&](id_type rt, int k) {
       push(rt);
-      int size_with_lson = Node::getSize(rt->lson);
+      int size_with_lson = Node::getSize(ref(rt).lson);
       if (k == size_with_lson) {
-        rt->val = v;
+        ref(rt).val = v;
       } else if (k < size_with_lson) {
-        change(rt->lson, k);
+        change(ref(rt).lson, k);
       } else {
-        change(rt->rson, k - size_with_lson - 1);
+        change(ref(rt).rson, k - size_with_lson - 1);
       }
       pull(rt);
     };
-    change(k, v);
+    change(rt, k);
     return *this;
   }
 
   std::vector<LazyReversibleInfo> flat() {
     std::vector<LazyReversibleInfo> res;
-    std::function<void(Node*)> travel = [&](Node* rt) {
+    std::function<void(id_type)> travel = [&](id_type rt) {
       if (!rt) return;
       push(rt);
-      travel(rt->lson);
-      res.push_back(rt->val);
-      travel(rt->rson);
+      travel(ref(rt).lson);
+      res.push_back(ref(rt).val);
+      travel(ref(rt).rson);
     };
     travel(rt);
     return res;
@@ -197,13 +224,13 @@ class LazyReversibleTreap {
   std::string to_string() const {
     std::ostringstream os;
     os << "{\n";
-    std::function<void(Node*)> travel = [&](Node* rt) {
+    std::function<void(id_type)> travel = [&](id_type rt) {
       if (!rt) return;
       push(rt);
-      os << " " << rt << ": (" << rt->lson << "," << rt->rson << ") "
-         << rt->size << " " << rt->val << "\n";
-      travel(rt->lson);
-      travel(rt->rson);
+      os << " " << rt << ": (" << ref(rt).lson << "," << ref(rt).rson << ") "
+         << ref(rt).size << " " << ref(rt).val << "\n";
+      travel(ref(rt).lson);
+      travel(ref(rt).rson);
     };
     travel(rt);
     os << "}";
@@ -217,15 +244,16 @@ class LazyReversibleTreap {
     if (!predicate(Node::getSum(rt))) return -1;
     int res = Node::getSize(rt);
     LazyReversibleInfo suffix_sum = LazyReversibleInfo();
-    for (Node* cur = rt;;) {
+    for (id_type cur = rt;;) {
       if (predicate(suffix_sum)) return res;
       push(cur);
-      if (predicate(Node::getSum(cur->rson) + suffix_sum)) {
-        cur = cur->rson;
+      const Node& c = ref(cur);
+      if (predicate(Node::getSum(c.rson) + suffix_sum)) {
+        cur = c.rson;
       } else {
-        suffix_sum = cur->val + Node::getSum(cur->rson) + suffix_sum;
-        res -= Node::getSize(cur->rson) + 1;
-        cur = cur->lson;
+        suffix_sum = c.val + Node::getSum(c.rson) + suffix_sum;
+        res -= Node::getSize(c.rson) + 1;
+        cur = c.lson;
       }
     }
   }
@@ -237,15 +265,16 @@ class LazyReversibleTreap {
     if (!predicate(Node::getSum(rt))) return Node::getSize(rt);
     int res = -1;
     LazyReversibleInfo prefix_sum = LazyReversibleInfo();
-    for (Node* cur = rt;;) {
+    for (id_type cur = rt;;) {
       if (predicate(prefix_sum)) return res;
       push(cur);
-      if (predicate(prefix_sum + Node::getSum(cur->lson))) {
-        cur = cur->lson;
+      const Node& c = ref(cur);
+      if (predicate(prefix_sum + Node::getSum(c.lson))) {
+        cur = c.lson;
       } else {
-        prefix_sum = prefix_sum + Node::getSum(cur->lson) + cur->val;
-        res += Node::getSize(cur->lson) + 1;
-        cur = cur->rson;
+        prefix_sum = prefix_sum + Node::getSum(c.lson) + c.val;
+        res += Node::getSize(c.lson) + 1;
+        cur = c.rson;
       }
     }
   }
@@ -269,6 +298,10 @@ class LazyReversibleTreap {
   }
 
  private:
+  explicit LazyReversibleTreap(id_type rt) : rt(rt) {}
+
+  static Node& ref(id_type x) { return pool()[x]; }
+
   // return [l,r), [r,n)
   std::pair<LazyReversibleTreap, LazyReversibleTreap> split3(int l, int r) {
     assert(l <= r);
@@ -277,77 +310,98 @@ class LazyReversibleTreap {
     return std::make_pair(std::move(middle), std::move(suffix));
   }
 
-  static Node* reverse(Node* rt) {
-    if (!rt) return nullptr;
-    rt->is_rev ^= true;
-    rt->val.reverse();
-    rt->sum.reverse();
+  // frees the subtree without recursion by rotating left sons up
+  static void release(id_type rt) {
+    while (rt) {
+      Node& x = ref(rt);
+      if (x.lson) {
+        id_type l = x.lson;
+        x.lson = ref(l).rson;
+        ref(l).rson = rt;
+        rt = l;
+      } else {
+        id_type r = x.rson;
+        pool().release(rt);
+        rt = r;
+      }
+    }
+  }
+
+  static id_type reverse(id_type rt) {
+    if (!rt) return 0;
+    Node& x = ref(rt);
+    x.is_rev ^= true;
+    x.val.reverse();
+    x.sum.reverse();
     return rt;
   }
 
-  static Node* apply(Node* rt, LazyTag t) {
-    if (!rt) return nullptr;
-    rt->val.apply(t);
-    rt->sum.apply(t);
-    rt->tag.apply(t);
+  static id_type apply(id_type rt, LazyTag t) {
+    if (!rt) return 0;
+    Node& x = ref(rt);
+    x.val.apply(t);
+    x.sum.apply(t);
+    x.tag.apply(t);
     return rt;
   }
 
-  static Node* push(Node* rt) {
-    if (!rt) return nullptr;
-    if (rt->is_rev) {
-      std::swap(rt->lson, rt->rson);
-      reverse(rt->lson);
-      reverse(rt->rson);
-      rt->is_rev = false;
+  static id_type push(id_type rt) {
+    if (!rt) return 0;
+    Node& x = ref(rt);
+    if (x.is_rev) {
+      std::swap(x.lson, x.rson);
+      reverse(x.lson);
+      reverse(x.rson);
+      x.is_rev = false;
     }
-    apply(rt->lson, rt->tag);
-    apply(rt->rson, rt->tag);
-    rt->tag = LazyTag();
+    apply(x.lson, x.tag);
+    apply(x.rson, x.tag);
+    x.tag = LazyTag();
     return rt;
   }
 
-  static Node* pull(Node* rt) {
-    if (!rt) return nullptr;
-    rt->size = Node::getSize(rt->lson) + 1 + Node::getSize(rt->rson);
-    rt->sum = Node::getSum(rt->lson) + rt->val + Node::getSum(rt->rson);
+  static id_type pull(id_type rt) {
+    if (!rt) return 0;
+    Node& x = ref(rt);
+    x.size = Node::getSize(x.lson) + 1 + Node::getSize(x.rson);
+    x.sum = Node::getSum(x.lson) + x.val + Node::getSum(x.rson);
     return rt;
   }
 
-  static Node* merge(Node* x, Node* y) {
+  static id_type merge(id_type x, id_type y) {
     if (!x) return y;
     if (!y) return x;
     push(x);
     push(y);
-    if (x->priority > y->priority) {
-      x->rson = merge(x->rson, y);
+    if (ref(x).priority > ref(y).priority) {
+      ref(x).rson = merge(ref(x).rson, y);
       return pull(x);
     } else {
-      y->lson = merge(x, y->lson);
+      ref(y).lson = merge(x, ref(y).lson);
       return pull(y);
     }
   }
 
   // split such that x->size=size
-  static void splitBySize(Node* rt, Node*& x, Node*& y, int size) {
+  static void splitBySize(id_type rt, id_type& x, id_type& y, int size) {
     if (!rt) {
-      x = y = nullptr;
+      x = y = 0;
       return;
     }
 
     push(rt);
-    int size_with_lson = Node::getSize(rt->lson) + 1;
+    int size_with_lson = Node::getSize(ref(rt).lson) + 1;
     if (size_with_lson <= size) {
       x = rt;
-      splitBySize(rt->rson, x->rson, y, size - size_with_lson);
+      splitBySize(ref(rt).rson, ref(x).rson, y, size - size_with_lson);
     } else {
       y = rt;
-      splitBySize(rt->lson, x, y->lson, size);
+      splitBySize(ref(rt).lson, x, ref(y).lson, size);
     }
     pull(rt);
   }
 
-  Node* rt;
+  id_type rt;
 };
 
-using Treap = LazyReversibleTreap<LazyReversibleInfo, LazyTag>;
\ No newline at end of file
+using Treap = LazyReversibleTreap<LazyReversibleInfo, LazyTag>;
@@ -0,0 +1,86 @@
+// Nodes addressed by 32-bit ids, id 0 is reserved as null.
+// Released ids are recycled by later allocations, reset() recycles every node
+// at once in O(1) (all ids handed out before become invalid).
+template <typename Node>
+class NodePool {
+ public:
+  using id_type = std::uint32_t;
+
+  template <typename... Args>
+  id_type allocate(Args&&... args) {
+    ++live;
+    if (free_ids.size()) {
+      id_type k = free_ids.back();
+      free_ids.pop_back();
+      nodes[k - 1] = Node(std::forward<Args>(args)...);
+      return k;
+    }
+    if (used < nodes.size()) {
+      nodes[used] = Node(std::forward<Args>(args)...);
+    } else {
+      nodes.emplace_back(std::forward<Args>(args)...);
+    }
+    return ++used;
+  }
+
+  // allocates a node for every value of [first,last) and links them in order
+  // into a treap (max-heap on `priority`) by the stack method of
+  // cartesian_tree.h, O(m). pull(k) is called on every node bottom-up.
+  template <typename It, typename Pull>
+  id_type build(It first, It last, Pull&& pull) {
+    std::vector<id_type> stk;
+    for (; first != last; ++first) {
+      id_type k = allocate(*first), last_popped = 0;
+      for (; stk.size() &&
+             (*this)[stk.back()].priority < (*this)[k].priority;
+           stk.pop_back()) {
+        last_popped = stk.back();
+        pull(last_popped);
+      }
+      (*this)[k].lson = last_popped;
+      if (stk.size()) (*this)[stk.back()].rson = k;
+      stk.push_back(k);
+    }
+    id_type rt = 0;
+    for (; stk.size(); stk.pop_back()) pull(rt = stk.back());
+    return rt;
+  }
+
+  // same as build but without priorities, every subtree is split at its
+  // middle element, O(m)
+  template <typename It, typename Pull>
+  id_type buildBalanced(It first, It last, Pull&& pull) {
+    if (first == last) return 0;
+    It mid = first + (last - first) / 2;
+    id_type l = buildBalanced(first, mid, pull);
+    id_type k = allocate(*mid);
+    id_type r = buildBalanced(mid + 1, last, pull);
+    (*this)[k].lson = l;
+    (*this)[k].rson = r;
+    pull(k);
+    return k;
+  }
+
+  void release(id_type k) {
+    assert(k);
+    free_ids.push_back(k);
+    --live;
+  }
+
+  void reset() {
+    used = live = 0;
+    free_ids.clear();
+  }
+
+  void reserve(size_t n) { nodes.reserve(n); }
+
+  // number of nodes currently allocated
+  size_t size() const { return live; }
+
+  Node& operator[](id_type k) { return nodes[k - 1]; }
+
+ private:
+  std::vector<Node> nodes;
+  std::vector<id_type> free_ids;
+  size_t used = 0, live = 0;
+};
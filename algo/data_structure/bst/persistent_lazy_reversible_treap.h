@@ -0,0 +1,338 @@
+// requires node_pool.h, LazyReversibleInfo/LazyTag as in
+// lazy_reversible_treap.h
+
+// Nodes are reference counted and shared between versions, every operation
+// copies the O(logn) nodes on its path instead of modifying shared ones.
+// There are no stored priorities, merge picks the root at random by size,
+// so sequences sharing nodes (t.append(t)) stay balanced.
+// Copying a treap is an O(1) snapshot.
+// (a+b)+c=a+(b+c)
+// f(a+b)=f(a)+f(b)
+template <typename LazyReversibleInfo, typename LazyTag>
+class PersistentLazyReversibleTreap {
+ public:
+  struct Node;
+  using Pool = NodePool<Node>;
+  using id_type = typename Pool::id_type;
+
+  struct Node {
+    LazyTag tag;
+    LazyReversibleInfo val, sum;
+    int size;
+    id_type refs;
+    bool is_rev, has_tag;
+    id_type lson, rson;
+    Node(LazyReversibleInfo v)
+        : val(v),
+          sum(v),
+          size(1),
+          refs(1),
+          is_rev(false),
+          has_tag(false),
+          lson(0),
+          rson(0) {}
+
+    static int getSize(id_type x) { return x ? ref(x).size : 0; }
+    static LazyReversibleInfo getSum(id_type x) {
+      return x ? ref(x).sum : LazyReversibleInfo();
+    }
+  };
+
+  // never destroyed, so that global treaps can still release their nodes
+  // at exit
+  static Pool& pool() {
+    static Pool& p = *new Pool;
+    return p;
+  }
+
+  PersistentLazyReversibleTreap() : rt(0) {}
+  PersistentLazyReversibleTreap(LazyReversibleInfo v)
+      : rt(pool().allocate(v)) {}
+  // O(n)
+  PersistentLazyReversibleTreap(const std::vector<LazyReversibleInfo>& a)
+      : rt(pool().buildBalanced(a.begin(), a.end(), pull)) {}
+  ~PersistentLazyReversibleTreap() { release(rt); }
+
+  // snapshot, O(1)
+  PersistentLazyReversibleTreap(const PersistentLazyReversibleTreap& trp)
+      : rt(share(trp.rt)) {}
+  PersistentLazyReversibleTreap& operator=(
+      const PersistentLazyReversibleTreap& trp) {
+    id_type old = rt;
+    rt = share(trp.rt);
+    release(old);
+    return *this;
+  }
+  PersistentLazyReversibleTreap(PersistentLazyReversibleTreap&& trp)
+      : rt(trp.rt) {
+    trp.rt = 0;
+  }
+  PersistentLazyReversibleTreap& operator=(
+      PersistentLazyReversibleTreap&& trp) {
+    if (this == &trp) return *this;
+    release(rt);
+    rt = trp.rt;
+    trp.rt = 0;
+    return *this;
+  }
+
+  int size() const { return Node::getSize(rt); }
+
+  // [l,r] as a new sequence, sharing nodes with this one
+  PersistentLazyReversibleTreap slice(int l, int r) const {
+    auto [prefix, middle, suffix] = split3(share(rt), l, r + 1);
+    release(prefix);
+    release(suffix);
+    return PersistentLazyReversibleTreap(middle);
+  }
+
+  // append trp after this, trp is not changed
+  PersistentLazyReversibleTreap& append(
+      const PersistentLazyReversibleTreap& trp) {
+    rt = merge(rt, share(trp.rt));
+    return *this;
+  }
+
+  PersistentLazyReversibleTreap& insert(int k, LazyReversibleInfo v) {
+    return insert(k, PersistentLazyReversibleTreap(v));
+  }
+
+  // insert trp before k-th
+  PersistentLazyReversibleTreap& insert(
+      int k, const PersistentLazyReversibleTreap& trp) {
+    id_type x, y;
+    splitBySize(rt, x, y, k);
+    rt = merge(merge(x, share(trp.rt)), y);
+    return *this;
+  }
+
+  PersistentLazyReversibleTreap& insertRange(
+      int k, const std::vector<LazyReversibleInfo>& a) {
+    return insert(k, PersistentLazyReversibleTreap(a));
+  }
+
+  PersistentLazyReversibleTreap& erase(int l, int r) {
+    auto [prefix, middle, suffix] = split3(rt, l, r + 1);
+    release(middle);
+    rt = merge(prefix, suffix);
+    return *this;
+  }
+
+  PersistentLazyReversibleTreap& reverse(int l, int r) {
+    auto [prefix, middle, suffix] = split3(rt, l, r + 1);
+    rt = merge(merge(prefix, reverse(mut(middle))), suffix);
+    return *this;
+  }
+
+  PersistentLazyReversibleTreap& apply(int l, int r, LazyTag t) {
+    auto [prefix, middle, suffix] = split3(rt, l, r + 1);
+    rt = merge(merge(prefix, apply(mut(middle), t)), suffix);
+    return *this;
+  }
+
+  LazyReversibleInfo sum() const { return Node::getSum(rt); }
+  // [l,r], does not copy any node
+  LazyReversibleInfo sum(int l, int r) const {
+    if (l > r) return LazyReversibleInfo();
+    assert(0 <= l && r < size());
+    return query(rt, l, r);
+  }
+
+  LazyReversibleInfo at(int k) const { return sum(k, k); }
+
+  // reverse() should commute with apply(), does not copy any node
+  std::vector<LazyReversibleInfo> flat() const {
+    std::vector<LazyReversibleInfo> res;
+    res.reserve(size());
+    // rev/tag: pending operations of all ancestors on this subtree
+    std::function<void(id_type, bool, const LazyTag&, bool)> travel =
+        [&](id_type rt, bool rev, const LazyTag& tag, bool has_tag) {
+          if (!rt) return;
+          const Node& x = ref(rt);
+          LazyTag sub_tag = x.tag;
+          if (has_tag) sub_tag.apply(tag);
+          bool sub_rev = rev ^ x.is_rev, sub_has_tag = has_tag || x.has_tag;
+          travel(sub_rev ? x.rson : x.lson, sub_rev, sub_tag, sub_has_tag);
+          res.push_back(x.val);
+          if (rev) res.back().reverse();
+          if (has_tag) res.back().apply(tag);
+          travel(sub_rev ? x.lson : x.rson, sub_rev, sub_tag, sub_has_tag);
+        };
+    travel(rt, false, LazyTag(), false);
+    return res;
+  }
+
+ private:
+  explicit PersistentLazyReversibleTreap(id_type rt) : rt(rt) {}
+
+  static Node& ref(id_type x) { return pool()[x]; }
+
+  static id_type share(id_type x) {
+    if (x) ++ref(x).refs;
+    return x;
+  }
+
+  static void release(id_type x) {
+    std::vector<id_type> stk = {x};
+    for (; stk.size();) {
+      id_type k = stk.back();
+      stk.pop_back();
+      if (!k || --ref(k).refs) continue;
+      stk.push_back(ref(k).lson);
+      stk.push_back(ref(k).rson);
+      pool().release(k);
+    }
+  }
+
+  // takes ownership of x, returns a node only owned by the caller with the
+  // same content
+  static id_type mut(id_type x) {
+    if (!x || ref(x).refs == 1) return x;
+    --ref(x).refs;
+    Node copy = ref(x);
+    copy.refs = 1;
+    share(copy.lson);
+    share(copy.rson);
+    return pool().allocate(copy);
+  }
+
+  // [0,l), [l,r), [r,n)
+  static std::tuple<id_type, id_type, id_type> split3(id_type rt, int l,
+                                                      int r) {
+    assert(l <= r);
+    id_type x, y, z;
+    splitBySize(rt, x, y, l);
+    splitBySize(y, y, z, r - l);
+    return {x, y, z};
+  }
+
+  // [l,r] of the subtree of x, with x's pending operations applied but not
+  // those of its ancestors
+  static LazyReversibleInfo query(id_type x, int l, int r) {
+    const Node& c = ref(x);
+    if (l == 0 && r == c.size - 1) return c.sum;
+    id_type L = c.lson, R = c.rson;
+    if (c.is_rev) std::swap(L, R);
+    // the pending reversal also mirrors positions inside the sons
+    auto sub = [&](id_type y, int l, int r) {
+      if (!c.is_rev) return query(y, l, r);
+      int n = Node::getSize(y);
+      LazyReversibleInfo v = query(y, n - 1 - r, n - 1 - l);
+      v.reverse();
+      return v;
+    };
+    auto fix = [&](LazyReversibleInfo v) {
+      if (c.has_tag) v.apply(c.tag);
+      return v;
+    };
+    int size_with_lson = Node::getSize(L);
+    LazyReversibleInfo res;
+    if (l < size_with_lson) {
+      res = fix(sub(L, l, std::min(r, size_with_lson - 1)));
+    }
+    if (l <= size_with_lson && size_with_lson <= r) res = res + c.val;
+    if (r > size_with_lson) {
+      res = res + fix(sub(R, std::max(l - size_with_lson - 1, 0),
+                          r - size_with_lson - 1));
+    }
+    return res;
+  }
+
+  // the following functions take ownership of their arguments, and modify
+  // only nodes they own exclusively
+
+  static id_type reverse(id_type rt) {
+    if (!rt) return 0;
+    Node& x = ref(rt);
+    x.is_rev ^= true;
+    x.val.reverse();
+    x.sum.reverse();
+    return rt;
+  }
+
+  static id_type apply(id_type rt, const LazyTag& t) {
+    if (!rt) return 0;
+    Node& x = ref(rt);
+    x.val.apply(t);
+    x.sum.apply(t);
+    x.tag.apply(t);
+    x.has_tag = true;
+    return rt;
+  }
+
+  // rt should be owned exclusively
+  static void push(id_type rt) {
+    if (!ref(rt).is_rev && !ref(rt).has_tag) return;
+    id_type l = mut(ref(rt).lson), r = mut(ref(rt).rson);
+    Node& x = ref(rt);
+    if (x.is_rev) {
+      std::swap(l, r);
+      reverse(l);
+      reverse(r);
+      x.is_rev = false;
+    }
+    if (x.has_tag) {
+      apply(l, x.tag);
+      apply(r, x.tag);
+      x.tag = LazyTag();
+      x.has_tag = false;
+    }
+    x.lson = l;
+    x.rson = r;
+  }
+
+  static void pull(id_type rt) {
+    Node& x = ref(rt);
+    x.size = Node::getSize(x.lson) + 1 + Node::getSize(x.rson);
+    x.sum = Node::getSum(x.lson) + x.val + Node::getSum(x.rson);
+  }
+
+  // x is the root with probability size(x)/(size(x)+size(y)), which keeps
+  // the tree random even when x and y share nodes, unlike fixed priorities
+  static id_type merge(id_type x, id_type y) {
+    if (!x) return y;
+    if (!y) return x;
+    static std::mt19937 engine(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+    int sx = Node::getSize(x), sy = Node::getSize(y);
+    if (std::uniform_int_distribution<int>(0, sx + sy - 1)(engine) < sx) {
+      x = mut(x);
+      push(x);
+      ref(x).rson = merge(ref(x).rson, y);
+      pull(x);
+      return x;
+    } else {
+      y = mut(y);
+      push(y);
+      ref(y).lson = merge(x, ref(y).lson);
+      pull(y);
+      return y;
+    }
+  }
+
+  // split such that x->size=size
+  static void splitBySize(id_type rt, id_type& x, id_type& y, int size) {
+    if (!rt) {
+      x = y = 0;
+      return;
+    }
+    rt = mut(rt);
+    push(rt);
+    int size_with_lson = Node::getSize(ref(rt).lson) + 1;
+    id_type l, r;
+    if (size_with_lson <= size) {
+      splitBySize(ref(rt).rson, l, r, size - size_with_lson);
+      ref(rt).rson = l;
+      x = rt;
+      y = r;
+    } else {
+      splitBySize(ref(rt).lson, l, r, size);
+      ref(rt).lson = r;
+      x = l;
+      y = rt;
+    }
+    pull(rt);
+  }
+
+  id_type rt;
+};
@@ -1,3 +1,5 @@
+// requires node_pool.h
+
 
 struct Info {
   int x, val;
@@ -33,13 +35,17 @@ struct AccumulatedInfo {
 template <typename Info, typename AccumulatedInfo>
 class treap {
  public:
+  struct node;
+  using pool_type = NodePool<node>;
+  using id_type = typename pool_type::id_type;
+
   struct node {
     Info info;
     AccumulatedInfo accumulated_info;
     using priority_type = unsigned int;
     priority_type priority;
     size_t size;
-    node *lson, *rson;
+    id_type lson, rson;
     static priority_type get_priority() {
       static std::mt19937_64 engine(
           std::chrono::steady_clock::now().time_since_epoch().count());
@@ -53,42 +59,85 @@ class treap {
           accumulated_info(info_),
           priority(get_priority()),
           size(1),
-          lson(nullptr),
-          rson(nullptr) {}
+          lson(0),
+          rson(0) {}
 
-    node* maintain() {
+    void maintain() {
       accumulated_info = AccumulatedInfo(info);
       size = 1;
       if (lson) {
-        accumulated_info = lson->accumulated_info + accumulated_info;
-        size += lson->size;
+        accumulated_info = ref(lson).accumulated_info + accumulated_info;
+        size += ref(lson).size;
       }
       if (rson) {
-        accumulated_info = accumulated_info + rson->accumulated_info;
-        size += rson->size;
+        accumulated_info = accumulated_info + ref(rson).accumulated_info;
+        size += ref(rson).size;
       }
-      return this;
     }
 
-    static size_t get_size(node* x) {
+    static size_t get_size(id_type x) {
       if (!x) return 0;
-      return x->size;
+      return ref(x).size;
     }
   };
 
+  // keeps the node and its ancestors, so ++/-- are amortized O(1).
+  // invalidated by insert/erase.
   struct iterator {
     treap* tree;
     int rank;
-    iterator(treap* tree_, int rank_) : tree(tree_), rank(rank_) {
-      assert(0 <= rank && rank <= node::get_size(tree->rt));
+    id_type cur;
+    std::vector<id_type> path;  // ancestors of cur, from the root
+
+    iterator(treap* tree_) : tree(tree_), rank(0), cur(0) {}
+
+    iterator& operator++() {
+      assert(cur);
+      ++rank;
+      if (ref(cur).rson) {
+        path.push_back(cur);
+        cur = ref(cur).rson;
+        for (; ref(cur).lson; cur = ref(cur).lson) path.push_back(cur);
+        return *this;
+      }
+      for (; path.size() && ref(path.back()).rson == cur; path.pop_back()) {
+        cur = path.back();
+      }
+      if (path.empty()) {
+        cur = 0;
+      } else {
+        cur = path.back();
+        path.pop_back();
+      }
+      return *this;
     }
-    iterator& operator++() { return *this = iterator(tree, rank + 1); }
     iterator operator++(int) {
       iterator res = *this;
       ++*this;
       return res;
     }
-    iterator& operator--() { return *this = iterator(tree, rank - 1); }
+    iterator& operator--() {
+      assert(rank > 0);
+      --rank;
+      if (!cur) {
+        cur = tree->rt;
+        for (; ref(cur).rson; cur = ref(cur).rson) path.push_back(cur);
+        return *this;
+      }
+      if (ref(cur).lson) {
+        path.push_back(cur);
+        cur = ref(cur).lson;
+        for (; ref(cur).rson; cur = ref(cur).rson) path.push_back(cur);
+        return *this;
+      }
+      for (; path.size() && ref(path.back()).lson == cur; path.pop_back()) {
+        cur = path.back();
+      }
+      assert(path.size());
+      cur = path.back();
+      path.pop_back();
+      return *this;
+    }
     iterator operator--(int) {
       iterator res = *this;
       --*this;
@@ -102,90 +151,131 @@ class treap {
     }
 
     int get_rank() { return rank; }
-    Info info() { return treap::get_kth(tree->rt, rank)->info; }
+    const Info& info() { return ref(cur).info; }
     AccumulatedInfo prefix_accumulated_info() {
-      AccumulatedInfo res;
-      auto handler = [&res](node* k) {
-        if (k->lson) {
-          res = res + k->lson->accumulated_info;
-        }
-        res = res + AccumulatedInfo(k->info);
-      };
-      node* nd = treap::get_kth(
-          tree->rt, rank,
-          /*go_left_handler=*/[&](node*) {},
-          /*go_right_handler=*/handler);
-      handler(nd);
+      const node& c = ref(cur);
+      AccumulatedInfo res = AccumulatedInfo(c.info);
+      if (c.lson) res = ref(c.lson).accumulated_info + res;
+      for (int i = (int)path.size() - 1; i >= 0; --i) {
+        const node& p = ref(path[i]);
+        if (p.lson == (i + 1 < path.size() ? path[i + 1] : cur)) continue;
+        res = AccumulatedInfo(p.info) + res;
+        if (p.lson) res = ref(p.lson).accumulated_info + res;
+      }
       return res;
     }
     AccumulatedInfo suffix_accumulated_info() {
-      AccumulatedInfo res;
-      auto handler = [&res](node* k) {
-        res = res + AccumulatedInfo(k->info);
-        if (k->rson) {
-          res = k->rson->accumulated_info + res;
-        }
-      };
-      node* nd = treap::get_kth(tree->rt, rank, /*go_left_handler=*/handler);
-      handler(nd);
+      const node& c = ref(cur);
+      AccumulatedInfo res = AccumulatedInfo(c.info);
+      if (c.rson) res = res + ref(c.rson).accumulated_info;
+      for (int i = (int)path.size() - 1; i >= 0; --i) {
+        const node& p = ref(path[i]);
+        if (p.rson == (i + 1 < path.size() ? path[i + 1] : cur)) continue;
+        res = res + AccumulatedInfo(p.info);
+        if (p.rson) res = res + ref(p.rson).accumulated_info;
+      }
       return res;
     }
   };
 
-  treap(node* rt_ = nullptr) : rt(rt_) {}
-  ~treap() {
-    std::function<void(node*)> delete_node = [&](node* rt) {
-      if (!rt) return;
-      delete_node(rt->lson);
-      delete_node(rt->rson);
-      delete rt;
-    };
-    delete_node(rt);
+  // all treaps of the same type share one pool. It is never destroyed, so
+  // that global treaps can still clear themselves at exit.
+  static pool_type& pool() {
+    static pool_type& p = *new pool_type;
+    return p;
   }
 
-  iterator begin() { return iterator(this, 0); }
-  iterator end() { return iterator(this, node::get_size(rt)); }
+  treap() : rt(0) {}
+  // O(n), a should be sorted
+  treap(const std::vector<Info>& a) : rt(build(a)) {}
+  ~treap() { clear(); }
 
-  iterator get_kth(int k) { return iterator(this, k); }
+  // O(1) if this treap holds every node of the pool, O(size) otherwise.
+  void clear() {
+    if (node::get_size(rt) == pool().size()) {
+      pool().reset();
+    } else {
+      release(rt);
+    }
+    rt = 0;
+  }
+
+  iterator begin() { return lowerbound_if([](const Info&) { return true; }); }
+  iterator end() {
+    iterator it(this);
+    it.rank = node::get_size(rt);
+    return it;
+  }
+
+  iterator get_kth(int k) {
+    assert(0 <= k && k <= node::get_size(rt));
+    iterator it(this);
+    it.rank = k;
+    for (id_type x = rt; x;) {
+      size_t size_with_lson = node::get_size(ref(x).lson) + 1;
+      if (size_with_lson == k + 1) {
+        it.cur = x;
+        return it;
+      }
+      it.path.push_back(x);
+      if (size_with_lson <= k) {
+        k -= size_with_lson;
+        x = ref(x).rson;
+      } else {
+        x = ref(x).lson;
+      }
+    }
+    it.path.clear();
+    return it;
+  }
 
   // the first one >=v
-  iterator lowerbound(Info v) {
-    return iterator(this, get_count(rt, [&](Info x) { return x < v; }));
+  iterator lowerbound(const Info& v) {
+    return lowerbound_if([&](const Info& x) { return !(x < v); });
   }
 
   // the first one >v
-  iterator upperbound(Info v) {
-    return iterator(this, get_count(rt, [&](Info x) { return x <= v; }));
+  iterator upperbound(const Info& v) {
+    return lowerbound_if([&](const Info& x) { return !(x <= v); });
   }
 
-  void insert(Info v) {
-    node* mid = new node(v);
-    node *l, *r;
-    split_by_info(rt, l, r, [&](Info x) { return x < v; });
+  void insert(const Info& v) {
+    id_type mid = pool().allocate(v);
+    id_type l, r;
+    split_by_info(rt, l, r, [&](const Info& x) { return x < v; });
     rt = merge(merge(l, mid), r);
   }
 
-  void erase(Info v, bool erase_all = false) {
-    node *l, *mid, *r;
-    split_by_info(rt, l, r, [&](Info x) { return x < v; });
-    split_by_info(r, mid, r, [&](Info x) { return x <= v; });
+  // insert all of a (need not be sorted), O(mlogm+mlog(n/m+1))
+  void insert_range(std::vector<Info> a) {
+    std::sort(a.begin(), a.end());
+    rt = join(rt, build(a));
+  }
+
+  void erase(const Info& v, bool erase_all = false) {
+    id_type l, mid, r;
+    split_by_info(rt, l, r, [&](const Info& x) { return x < v; });
+    split_by_info(r, mid, r, [&](const Info& x) { return x <= v; });
     if (mid) {
       if (erase_all) {
-        mid = nullptr;
+        release(mid);
+        mid = 0;
       } else {
-        mid = merge(mid->lson, mid->rson);
+        id_type removed = mid;
+        mid = merge(ref(mid).lson, ref(mid).rson);
+        pool().release(removed);
       }
     }
     rt = merge(merge(l, mid), r);
   }
 
-  AccumulatedInfo inline lesum(Info v) {
+  AccumulatedInfo inline lesum(const Info& v) {
     iterator it = upperbound(v);
     if (it == begin()) return AccumulatedInfo();
     --it;
     return it.prefix_accumulated_info();
   }
-  AccumulatedInfo inline resum(Info v) {
+  AccumulatedInfo inline resum(const Info& v) {
     iterator it = lowerbound(v);
     if (it == end()) return AccumulatedInfo();
     return it.suffix_accumulated_info();
@@ -195,89 +285,140 @@ class treap {
   treap(const treap& tr) = delete;
 
  private:
-  static node* merge(node* x, node* y) {
+  static node& ref(id_type x) { return pool()[x]; }
+
+  // frees the subtree without recursion by rotating left sons up
+  static void release(id_type rt) {
+    while (rt) {
+      node& x = ref(rt);
+      if (x.lson) {
+        id_type l = x.lson;
+        x.lson = ref(l).rson;
+        ref(l).rson = rt;
+        rt = l;
+      } else {
+        id_type r = x.rson;
+        pool().release(rt);
+        rt = r;
+      }
+    }
+  }
+
+  static id_type build(const std::vector<Info>& a) {
+    assert(std::is_sorted(a.begin(), a.end()));
+    return pool().build(a.begin(), a.end(),
+                        [](id_type k) { ref(k).maintain(); });
+  }
+
+  // union of two treaps with arbitrary interleaving keys
+  static id_type join(id_type x, id_type y) {
     if (!x) return y;
     if (!y) return x;
-    if (x->priority > y->priority) {
-      x->rson = merge(x->rson, y);
-      return x->maintain();
-    } else {
-      y->lson = merge(x, y->lson);
-      return y->maintain();
-    }
+    if (ref(x).priority < ref(y).priority) std::swap(x, y);
+    id_type l, r;
+    split_by_info(y, l, r,
+                  [&](const Info& v) { return v < ref(x).info; });
+    ref(x).lson = join(ref(x).lson, l);
+    ref(x).rson = join(ref(x).rson, r);
+    ref(x).maintain();
+    return x;
   }
 
-  // split such that predicate(all node in x)=true
-  // precondition: if predicate(rt[i])=false, predicate(rt[j])=false for i<=j
-  static void split_by_info(node* rt, node*& x, node*& y,
-                            const std::function<bool(Info)>& predicate) {
-    if (!rt) {
-      x = nullptr;
-      y = nullptr;
-      return;
-    }
-    if (predicate(rt->info)) {
-      x = rt;
-      split_by_info(rt->rson, x->rson, y, predicate);
-    } else {
-      y = rt;
-      split_by_info(rt->lson, x, y->lson, predicate);
-    }
-    rt->maintain();
+  // scratch stack of the nodes to maintain after an iterative split/merge
+  static std::vector<id_type>& trail() {
+    static std::vector<id_type> stk;
+    return stk;
   }
 
-  // split such that x->size=size
-  static void split_by_size(node* rt, node*& x, node*& y, size_t size) {
-    if (!rt) {
-      x = nullptr;
-      y = nullptr;
-      return;
+  static void maintain_trail() {
+    auto& stk = trail();
+    for (; stk.size(); stk.pop_back()) ref(stk.back()).maintain();
+  }
+
+  static id_type merge(id_type x, id_type y) {
+    id_type res;
+    id_type* hook = &res;
+    for (; x && y;) {
+      if (ref(x).priority > ref(y).priority) {
+        *hook = x;
+        trail().push_back(x);
+        hook = &ref(x).rson;
+        x = ref(x).rson;
+      } else {
+        *hook = y;
+        trail().push_back(y);
+        hook = &ref(y).lson;
+        y = ref(y).lson;
+      }
     }
+    *hook = x ? x : y;
+    maintain_trail();
+    return res;
+  }
 
-    size_t size_with_lson = node::get_size(rt->lson) + 1;
-    if (size_with_lson <= size) {
-      x = rt;
-      split_by_size(rt->rson, x->rson, y, size - size_with_lson);
-    } else {
-      y = rt;
-      split_by_size(rt->lson, x, y->lson, size);
+  // split such that predicate(all node in x)=true
+  // precondition: if predicate(rt[i])=false, predicate(rt[j])=false for i<=j
+  template <typename Predicate>
+  static void split_by_info(id_type rt, id_type& x, id_type& y,
+                            Predicate&& predicate) {
+    id_type *lhook = &x, *rhook = &y;
+    for (; rt;) {
+      trail().push_back(rt);
+      if (predicate(ref(rt).info)) {
+        *lhook = rt;
+        lhook = &ref(rt).rson;
+        rt = ref(rt).rson;
+      } else {
+        *rhook = rt;
+        rhook = &ref(rt).lson;
+        rt = ref(rt).lson;
+      }
     }
-    rt->maintain();
+    *lhook = *rhook = 0;
+    maintain_trail();
   }
 
-  static size_t get_count(node* rt,
-                          const std::function<bool(Info)>& predicate) {
-    size_t res = 0;
+  // split such that x->size=size
+  static void split_by_size(id_type rt, id_type& x, id_type& y, size_t size) {
+    id_type *lhook = &x, *rhook = &y;
     for (; rt;) {
-      if (predicate(rt->info)) {
-        res += node::get_size(rt->lson) + 1;
-        rt = rt->rson;
+      trail().push_back(rt);
+      size_t size_with_lson = node::get_size(ref(rt).lson) + 1;
+      if (size_with_lson <= size) {
+        size -= size_with_lson;
+        *lhook = rt;
+        lhook = &ref(rt).rson;
+        rt = ref(rt).rson;
       } else {
-        rt = rt->lson;
+        *rhook = rt;
+        rhook = &ref(rt).lson;
+        rt = ref(rt).lson;
       }
     }
-    return res;
+    *lhook = *rhook = 0;
+    maintain_trail();
   }
 
-  // index from 0
-  static node* get_kth(
-      node* rt, int k,
-      const std::function<void(node*)>& go_left_handler = [&](node*) {},
-      const std::function<void(node*)>& go_right_handler = [&](node*) {}) {
-    assert(0 <= k && k < rt->size);
-    for (++k;;) {
-      size_t size_with_lson = node::get_size(rt->lson) + 1;
-      if (size_with_lson == k) return rt;
-      if (size_with_lson <= k) {
-        go_right_handler(rt);
-        k -= size_with_lson;
-        rt = rt->rson;
+  // the first node s.t. predicate(info)=true
+  // precondition: if predicate(rt[i])=true, predicate(rt[j])=true for i<=j
+  template <typename Predicate>
+  iterator lowerbound_if(Predicate&& predicate) {
+    iterator it(this);
+    int depth = 0;
+    for (id_type x = rt; x;) {
+      it.path.push_back(x);
+      if (predicate(ref(x).info)) {
+        it.cur = x;
+        depth = it.path.size() - 1;
+        x = ref(x).lson;
       } else {
-        go_left_handler(rt);
-        rt = rt->lson;
+        it.rank += node::get_size(ref(x).lson) + 1;
+        x = ref(x).rson;
       }
     }
+    it.path.resize(it.cur ? depth : 0);
+    return it;
   }
 
-  node* rt;
+  id_type rt;
 };
@@ -1,85 +1,235 @@
-template <class Info>
+// parallelBuild works with ThreadPool in thread_pool.h
+// Info is the edge weight, with Info() as zero, + and <.
+// build is O(nlogn) without recursion, it stores the centroid tree (cpar,
+// level) and the distance from every vertex to each of its centroid
+// ancestors, so that mark/nearestMarked/distance are O(logn).
+// Scratch buffers are allocated once per build (per thread for
+// parallelBuild).
+template <class Info = int>
 struct CentroidDecomposition {
-  CentroidDecomposition(int n) : n(n), G(n) {}
+  CentroidDecomposition(int n) : n(n) {}
 
-  void addEdge(int u, int v, Info w = Info()) {
-    G[u].emplace_back(v, w);
-    G[v].emplace_back(u, w);
-  }
+  void addEdge(int u, int v, Info w = Info(1)) { edges.emplace_back(u, v, w); }
 
-  // mainly need to implement centroid_inclusion / u_exclusion
-  // i.e. given a bfs sequence, where node i's parent is given as fa[i]
-  long long solve(int m) {
-    std::vector<bool> vis(n);
-    std::vector<int> fa(n, -1);
-    std::vector<size_t> size(n);
-    std::vector<size_t> max_size(n);
-
-    std::vector<int> dep(n);
-
-    long long ans = 0;
-    auto calc = [&](const std::vector<int>& q, int base_len) {
-      dep[q.front()] = base_len;
-      std::vector<long long> cnt(q.size() + base_len);
-      for (int u : q) {
-        if (~fa[u]) dep[u] = dep[fa[u]] + 1;
-        ++cnt[dep[u]];
+  // calc(centroid, q, dis, branch) is called once for every centroid, where q
+  // is the bfs order of its component starting from the centroid, dis[i] the
+  // distance from q[i] to the centroid and branch[i] the son of the centroid
+  // whose subtree contains q[i] (the centroid itself for i=0).
+  // Paths through the centroid are pairs with different branches, e.g.
+  // count pairs in the whole component, then subtract those of each branch.
+  template <class Calc>
+  void build(Calc&& calc) {
+    prepare(1);
+    Scratch& sc = scratch[0];
+    for (int s = 0; s < n; ++s) {
+      if (removed[s]) continue;
+      for (sc.stk.emplace_back(s, -1); sc.stk.size();) {
+        auto [u, p] = sc.stk.back();
+        sc.stk.pop_back();
+        int c = process(u, p, sc);
+        calc(c, std::as_const(sc.q), std::as_const(sc.dis),
+             std::as_const(sc.branch));
+        for (int j = head[c]; j < head[c + 1]; ++j) {
+          if (!removed[adj[j].first]) sc.stk.emplace_back(adj[j].first, c);
+        }
       }
-    };
-    auto centroid_inclusion = [&](const std::vector<int>& q) {
-      ans += calc(q, 0);
-    };
+    }
+  }
 
-    auto u_exclusion = [&](const std::vector<int>& q) { ans -= calc(q, 1); };
-
-    auto bfs = [&](int u) {
-      std::vector<int> q;
-      fa[u] = -1;
-      q.push_back(u);
-      for (int i = 0; i < q.size(); ++i) {
-        int u = q[i];
-        for (auto& [v, _] : G[u]) {
-          if (vis[v] || fa[u] == v) continue;
-          fa[v] = u;
-          q.push_back(v);
+  // Same as build, but independent components are decomposed in parallel,
+  // components smaller than grain are decomposed by the thread that found
+  // them. calc(w, centroid, q, dis, branch) runs on worker w, so it may
+  // accumulate into per-thread results (indexed by w) to be merged after.
+  template <class Pool, class Calc>
+  void parallelBuild(Pool& pool, Calc&& calc, int grain = 1 << 12) {
+    prepare(pool.size());
+    // decomposes the component of s whose father centroid is sp on worker w
+    std::function<void(int, int, int)> decompose = [&](int w, int s, int sp) {
+      Scratch& sc = scratch[w];
+      for (sc.stk.emplace_back(s, sp); sc.stk.size();) {
+        auto [u, p] = sc.stk.back();
+        sc.stk.pop_back();
+        int c = process(u, p, sc);
+        calc(w, c, std::as_const(sc.q), std::as_const(sc.dis),
+             std::as_const(sc.branch));
+        // size of the component of every son
+        for (int i = 1; i < sc.q.size() && fa[sc.q[i]] == c; ++i) {
+          size[sc.q[i]] = 0;
+        }
+        for (int i = 1; i < sc.q.size(); ++i) ++size[sc.branch[i]];
+        for (int j = head[c]; j < head[c + 1]; ++j) {
+          int v = adj[j].first;
+          if (removed[v]) continue;
+          if (size[v] < grain) {
+            sc.stk.emplace_back(v, c);
+            continue;
+          }
+          pool.spawn(w, [&, v, c](int w) { decompose(w, v, c); });
         }
       }
-      return q;
     };
-    auto get_centroid = [&](const std::vector<int>& q) {
-      int centroid = -1;
-      for (int u : q) {
-        size[u] = 1;
-        max_size[u] = 0;
+    // one task for every tree of the forest, found by a bfs with removed as
+    // the visited mark
+    std::vector<int> roots;
+    for (int s = 0; s < n; ++s) {
+      if (removed[s]) continue;
+      roots.push_back(s);
+      for (bfs(s, scratch[0]); int u : scratch[0].q) removed[u] = true;
+    }
+    removed.assign(n, false);
+    pool.run([&](int w) {
+      for (int s : roots) {
+        pool.spawn(w, [&, s](int w) { decompose(w, s, -1); });
       }
-      for (int i = q.size() - 1; i >= 0; --i) {
-        int u = q[i];
-        max_size[u] = std::max(max_size[u], q.size() - size[u]);
-        if (!~centroid || max_size[u] < max_size[centroid]) centroid = u;
-        if (~fa[u]) {
-          size[fa[u]] += size[u];
-          max_size[fa[u]] = std::max(max_size[fa[u]], size[u]);
-        }
+    });
+  }
+
+  // distance from u to its ancestor in the centroid tree at level l
+  Info ancestorDis(int u, int l) const { return anc_dis[u * L + l]; }
+
+  // u and v should be connected
+  Info distance(int u, int v) const {
+    int x = u, y = v;
+    while (x != y) {
+      if (level[x] < level[y]) std::swap(x, y);
+      x = cpar[x];
+    }
+    return ancestorDis(u, level[x]) + ancestorDis(v, level[x]);
+  }
+
+  void mark(int u) {
+    for (int c = u; ~c; c = cpar[c]) {
+      Info d = ancestorDis(u, level[c]);
+      if (!~best_vert[c] || d < best_dis[c]) best_dis[c] = d, best_vert[c] = u;
+    }
+  }
+
+  void clearMarks() { best_vert.assign(n, -1); }
+
+  // {distance, vertex} of the nearest marked vertex connected to u,
+  // vertex is -1 if there is none
+  std::pair<Info, int> nearestMarked(int u) const {
+    std::pair<Info, int> res(Info(), -1);
+    for (int c = u; ~c; c = cpar[c]) {
+      if (!~best_vert[c]) continue;
+      Info d = ancestorDis(u, level[c]) + best_dis[c];
+      if (!~res.second || d < res.first) res = {d, best_vert[c]};
+    }
+    return res;
+  }
+
+  int n, L;
+  // father in the centroid tree (-1 for roots), level of the root is 0
+  std::vector<int> cpar, level;
+
+ private:
+  struct Scratch {
+    // indexed by position in q
+    std::vector<int> q, branch;
+    std::vector<Info> dis;
+    std::vector<std::pair<int, int>> stk;
+  };
+
+  void prepare(int threads) {
+    std::vector<int> start(n + 1);
+    adj.resize(edges.size() * 2);
+    for (auto& [u, v, w] : edges) ++start[u], ++start[v];
+    for (int i = 0; i < n; ++i) start[i + 1] += start[i];
+    for (auto& [u, v, w] : edges) {
+      adj[--start[u]] = {v, w};
+      adj[--start[v]] = {u, w};
+    }
+    head = std::move(start);
+
+    L = std::__lg(std::max(n, 1)) + 1;
+    cpar.assign(n, -1);
+    level.assign(n, 0);
+    anc_dis.assign(n * L, Info());
+    best_dis.assign(n, Info());
+    best_vert.assign(n, -1);
+    removed.assign(n, false);
+    fa.resize(n);
+    size.resize(n);
+    scratch.resize(threads);
+    for (auto& sc : scratch) {
+      sc.q.reserve(n);
+      sc.branch.reserve(n);
+      sc.dis.reserve(n);
+    }
+  }
+
+  // fills q with the component of u in bfs order, fa as the father in it
+  void bfs(int u, Scratch& sc) {
+    auto& q = sc.q;
+    q.assign(1, u);
+    fa[u] = -1;
+    for (int i = 0; i < q.size(); ++i) {
+      int x = q[i];
+      for (int j = head[x]; j < head[x + 1]; ++j) {
+        int y = adj[j].first;
+        if (removed[y] || y == fa[x]) continue;
+        fa[y] = x;
+        q.push_back(y);
       }
-      return centroid;
-    };
-    std::function<void(int, int)> decomposition = [&](int u,
-                                                      int last_centroid) {
-      auto uq = bfs(u);
-      if (~last_centroid) u_exclusion(uq);
-      int centroid = get_centroid(uq);
-      auto cq = bfs(centroid);
-      centroid_inclusion(cq);
-      vis[centroid] = true;
-      for (auto& [v, _] : G[centroid]) {
-        if (vis[v]) continue;
-        decomposition(v, centroid);
+    }
+  }
+
+  int centroid(int u, Scratch& sc) {
+    bfs(u, sc);
+    int m = sc.q.size();
+    for (int x : sc.q) size[x] = 1;
+    for (int i = m - 1; i > 0; --i) {
+      int x = sc.q[i];
+      if (size[x] * 2 >= m) return x;
+      size[fa[x]] += size[x];
+    }
+    return u;
+  }
+
+  // bfs from the centroid c, filling q, dis and branch
+  void collect(int c, Scratch& sc) {
+    auto &q = sc.q, &branch = sc.branch;
+    auto& dis = sc.dis;
+    q.assign(1, c);
+    dis.assign(1, Info());
+    branch.assign(1, c);
+    fa[c] = -1;
+    for (int i = 0; i < q.size(); ++i) {
+      int x = q[i];
+      for (int j = head[x]; j < head[x + 1]; ++j) {
+        auto [y, w] = adj[j];
+        if (removed[y] || y == fa[x]) continue;
+        Info d = dis[i] + w;
+        fa[y] = x;
+        q.push_back(y);
+        dis.push_back(d);
+        branch.push_back(i ? branch[i] : y);
       }
-    };
-    decomposition(0, -1);
-    return ans;
+    }
+  }
+
+  // decomposes the component of u whose father centroid is p, returns its
+  // centroid, the component is left in sc
+  int process(int u, int p, Scratch& sc) {
+    int c = centroid(u, sc);
+    cpar[c] = p;
+    level[c] = ~p ? level[p] + 1 : 0;
+    collect(c, sc);
+    for (int i = 0; i < sc.q.size(); ++i) {
+      anc_dis[sc.q[i] * L + level[c]] = sc.dis[i];
+    }
+    removed[c] = true;
+    return c;
   }
 
-  int n;
-  std::vector<std::vector<std::pair<int, Info>>> G;
+  std::vector<std::tuple<int, int, Info>> edges;
+  std::vector<int> head;
+  std::vector<std::pair<int, Info>> adj;
+  std::vector<Info> anc_dis, best_dis;
+  std::vector<int> best_vert;
+  // components never share a vertex or an edge, so threads working on
+  // different ones may use these vertex indexed arrays at the same time
+  std::vector<char> removed;
+  std::vector<int> fa, size;
+  std::vector<Scratch> scratch;
 };
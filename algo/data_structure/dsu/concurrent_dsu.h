@@ -0,0 +1,66 @@
+// merge_edges(pool, ...) works with ThreadPool in thread_pool.h
+// Lock-free union-find for concurrent find/merge/is_in_same_set from any
+// number of threads, in the style of Anderson and Woll.
+// A root is linked below the root with the larger index by one CAS, which
+// is retried if either stopped being a root, so parents only grow and no
+// cycle can form. find halves the path with CAS as well, a failed one only
+// means another thread already shortened it.
+// Set sizes are not kept.
+class concurrent_dsu {
+ public:
+  concurrent_dsu(int n_) : n(n_), fa(n_) {
+    for (int i = 0; i < n_; ++i) fa[i].store(i, std::memory_order_relaxed);
+  }
+
+  int find(int i) {
+    for (;;) {
+      int p = fa[i].load(std::memory_order_acquire);
+      int g = fa[p].load(std::memory_order_acquire);
+      if (p == g) return p;
+      fa[i].compare_exchange_weak(p, g, std::memory_order_acq_rel);
+      i = g;
+    }
+  }
+
+  // linearizable: u and v were in the same set at some point of the call
+  bool is_in_same_set(int u, int v) {
+    for (;;) {
+      u = find(u), v = find(v);
+      if (u == v) return true;
+      // u is still a root, so they were apart when v was found
+      if (fa[u].load(std::memory_order_acquire) == u) return false;
+    }
+  }
+
+  // returns whether this call joined two sets
+  bool merge(int u, int v) {
+    for (;;) {
+      u = find(u), v = find(v);
+      if (u == v) return false;
+      if (u < v) std::swap(u, v);
+      int expected = v;
+      if (fa[v].compare_exchange_strong(expected, u,
+                                        std::memory_order_acq_rel)) {
+        return true;
+      }
+    }
+  }
+
+  // merges every pair on the pool, grain pairs per task, returns the number
+  // of merges that joined two sets
+  template <class Pool>
+  long long merge_edges(Pool& pool, std::span<const std::pair<int, int>> edges,
+                        int grain = 1 << 14) {
+    std::atomic<long long> res = 0;
+    pool.parallelFor(0, edges.size(), [&](int l, int r, int) {
+      int cnt = 0;
+      for (int i = l; i < r; ++i) cnt += merge(edges[i].first, edges[i].second);
+      res.fetch_add(cnt, std::memory_order_relaxed);
+    }, grain);
+    return res;
+  }
+
+ private:
+  const int n;
+  std::vector<std::atomic<int>> fa;
+};
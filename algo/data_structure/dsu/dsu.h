@@ -1,23 +1,44 @@
+// Union by size with path halving, amortized O(α(n)) per operation, and
+// find is iterative so long chains can not overflow the stack.
 class disjoint_set_union {
  public:
-  disjoint_set_union(int n_) : n(n_), fa(n_, -1), sz(n_, 1) {}
+  disjoint_set_union(int n_) : n(n_), fa(n_, -1), sz(n_, 1), count(n_) {}
 
-  int find(int i) { return !~fa[i] ? i : fa[i] = find(fa[i]); }
+  int find(int i) {
+    while (~fa[i]) {
+      if (~fa[fa[i]]) fa[i] = fa[fa[i]];
+      i = fa[i];
+    }
+    return i;
+  }
 
   bool is_in_same_set(int u, int v) { return find(u) == find(v); }
 
   int get_size(int u) { return sz[find(u)]; }
 
+  // number of sets
+  int components() const { return count; }
+
   bool merge(int u, int v) {
     int fu = find(u), fv = find(v);
     if (fu == fv) return false;
+    if (sz[fu] < sz[fv]) std::swap(fu, fv);
     sz[fu] += sz[fv];
     fa[fv] = fu;
+    --count;
     return true;
   }
 
+  // merges every pair, returns the number of merges that joined two sets
+  int merge_edges(std::span<const std::pair<int, int>> edges) {
+    int res = 0;
+    for (auto [u, v] : edges) res += merge(u, v);
+    return res;
+  }
+
  private:
   const int n;
   std::vector<int> fa;
   std::vector<int> sz;
-};
\ No newline at end of file
+  int count;
+};
@@ -1,33 +1,43 @@
+// Union by size without path compression, so that merges can be undone.
+// Every successful merge logs the old values it overwrites into one flat
+// ops list, version() is its length and rollback(version) undoes every
+// merge done after it. Failed merges log nothing.
 class rollbackable_dsu {
  public:
   rollbackable_dsu(int n_)
-      : n(n_), fa(n_, -1), sz(n_, 1), id(n_), global_id(n_) {
+      : n(n_), fa(n_, -1), sz(n_, 1), global_id(n_), id(n_), count(n_) {
     for (int i = 0; i < n_; ++i) id[i] = i;
   }
   int find(int i) {
     while (~fa[i]) i = fa[i];
     return i;
   }
+  // a fresh id is given to the component made by every merge
   int component_id(int u) { return id[find(u)]; }
+  bool is_in_same_set(int u, int v) { return find(u) == find(v); }
+  int get_size(int u) { return sz[find(u)]; }
+  // number of sets
+  int components() const { return count; }
   bool merge(int u, int v) {
-    ops.push_back({});
     int fu = find(u), fv = find(v);
     if (fu == fv) return false;
     if (sz[fu] < sz[fv]) std::swap(fu, fv);
-    auto& version = ops.back();
-    version.emplace_back(&sz[fu], sz[fu]);
-    version.emplace_back(&fa[fv], fa[fv]);
-    version.emplace_back(&id[fu], id[fu]);
+    ops.emplace_back(&sz[fu], sz[fu]);
+    ops.emplace_back(&fa[fv], fa[fv]);
+    ops.emplace_back(&id[fu], id[fu]);
+    ops.emplace_back(&count, count);
     sz[fu] += sz[fv];
     fa[fv] = fu;
     id[fu] = global_id++;
+    --count;
     return true;
   }
-  void rollback() {
-    for (auto [ptr, val] : ops.back()) {
-      *ptr = val;
+  int version() const { return ops.size(); }
+  void rollback(int version) {
+    while (ops.size() > version) {
+      *ops.back().first = ops.back().second;
+      ops.pop_back();
     }
-    ops.pop_back();
   }
 
  private:
@@ -37,5 +47,6 @@ class rollbackable_dsu {
 
   int global_id;
   std::vector<int> id;
-  std::vector<std::vector<std::pair<int*, int>>> ops;
-};
\ No newline at end of file
+  int count;
+  std::vector<std::pair<int*, int>> ops;
+};
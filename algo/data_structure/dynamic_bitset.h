@@ -0,0 +1,155 @@
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Bitset of runtime size, stored in 64-byte aligned blocks of words. Bits
+// past size() are always 0.
+// Bulk operations are O(n/w), using AVX2 when compiled with it (-mavx2).
+class DynamicBitset {
+ public:
+  using word = std::uint64_t;
+  static constexpr int W = 64;
+
+  DynamicBitset(std::size_t n = 0) : n(n), blocks((n + 511) / 512) {}
+
+  std::size_t size() const { return n; }
+  std::size_t words() const { return (n + W - 1) / W; }
+  word* data() { return blocks.empty() ? nullptr : blocks[0].w; }
+  const word* data() const { return blocks.empty() ? nullptr : blocks[0].w; }
+
+  bool operator[](std::size_t i) const { return data()[i / W] >> (i % W) & 1; }
+  void set(std::size_t i) { data()[i / W] |= word(1) << (i % W); }
+  void reset(std::size_t i) { data()[i / W] &= ~(word(1) << (i % W)); }
+  void reset() { std::fill(blocks.begin(), blocks.end(), Block()); }
+
+  std::size_t count() const {
+    std::size_t res = 0;
+    for (std::size_t i = 0; i < words(); ++i) {
+      res += __builtin_popcountll(data()[i]);
+    }
+    return res;
+  }
+  bool none() const {
+    for (std::size_t i = 0; i < words(); ++i) {
+      if (data()[i]) return false;
+    }
+    return true;
+  }
+  bool any() const { return !none(); }
+  // (*this & b).any() without building it
+  bool intersects(const DynamicBitset& b) const {
+    const word *x = data(), *y = b.data();
+    for (std::size_t i = 0, m = std::min(words(), b.words()); i < m; ++i) {
+      if (x[i] & y[i]) return true;
+    }
+    return false;
+  }
+
+  // b should not be longer
+  DynamicBitset& operator|=(const DynamicBitset& b) { return combine<OR>(b); }
+  DynamicBitset& operator^=(const DynamicBitset& b) { return combine<XOR>(b); }
+  DynamicBitset& operator&=(const DynamicBitset& b) {
+    assert(b.n == n);
+    return combine<AND>(b);
+  }
+
+  // *this |= *this << x, in place without a temporary
+  DynamicBitset& shiftOr(std::size_t x) { return orShifted(*this, x); }
+
+  // *this |= b << x, b may be *this, and should not be longer
+  DynamicBitset& orShifted(const DynamicBitset& b, std::size_t x) {
+    orShifted(b, x, 0, words());
+    return *this;
+  }
+
+  // orShifted restricted to the words [l,r) of *this, b may be *this only if
+  // [l,r) covers all words. Disjoint ranges can be done in parallel.
+  void orShifted(const DynamicBitset& b, std::size_t x, std::size_t l,
+                 std::size_t r) {
+    // dst[i] |= src[i-q] << s | src[i-q-1] >> (W-s), from high to low so
+    // that src==dst only reads words before they are changed
+    std::size_t q = x / W, s = x % W, m = b.words();
+    word* dst = data();
+    const word* src = b.data();
+    auto get = [&](std::size_t i) {
+      word hi = i >= q && i - q < m ? src[i - q] : 0;
+      word lo = s && i >= q + 1 && i - q - 1 < m ? src[i - q - 1] : 0;
+      return hi << s | (s ? lo >> (W - s) : 0);
+    };
+    std::size_t i = r;
+    // [lo_end,hi_end): both source words are inside b
+    std::size_t lo_end = std::max(l, q + 1), hi_end = std::min(r, m + q);
+    if (lo_end < hi_end) {
+      for (; i > hi_end; --i) dst[i - 1] |= get(i - 1);
+#ifdef __AVX2__
+      __m128i sl = _mm_cvtsi64_si128(s), sr = _mm_cvtsi64_si128(W - s);
+      for (; i >= lo_end + 4; i -= 4) {
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(src + i - q - 4));
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(src + i - q - 5));
+        __m256i* p = (__m256i*)(dst + i - 4);
+        __m256i v = _mm256_or_si256(_mm256_sll_epi64(hi, sl),
+                                    _mm256_srl_epi64(lo, sr));
+        _mm256_storeu_si256(p, _mm256_or_si256(_mm256_loadu_si256(p), v));
+      }
+#endif
+      if (s) {
+        for (; i > lo_end; --i) {
+          dst[i - 1] |= src[i - 1 - q] << s | src[i - 2 - q] >> (W - s);
+        }
+      } else {
+        for (; i > lo_end; --i) dst[i - 1] |= src[i - 1 - q];
+      }
+    }
+    for (; i > l; --i) dst[i - 1] |= get(i - 1);
+    if (r == words()) trim();
+  }
+
+  friend bool operator==(const DynamicBitset& a, const DynamicBitset& b) {
+    return a.n == b.n && a.blocks == b.blocks;
+  }
+
+ private:
+  struct alignas(64) Block {
+    word w[8] = {};
+    bool operator==(const Block&) const = default;
+  };
+
+  enum Op { OR, AND, XOR };
+
+  template <Op op>
+  static word apply(word x, word y) {
+    return op == OR ? x | y : op == AND ? x & y : x ^ y;
+  }
+#ifdef __AVX2__
+  template <Op op>
+  static __m256i apply(__m256i x, __m256i y) {
+    return op == OR    ? _mm256_or_si256(x, y)
+           : op == AND ? _mm256_and_si256(x, y)
+                       : _mm256_xor_si256(x, y);
+  }
+#endif
+
+  template <Op op>
+  DynamicBitset& combine(const DynamicBitset& b) {
+    assert(b.n <= n);
+    word* x = data();
+    const word* y = b.data();
+    std::size_t i = 0, m = b.words();
+#ifdef __AVX2__
+    for (; i + 4 <= m; i += 4) {
+      __m256i v = apply<op>(_mm256_load_si256((const __m256i*)(x + i)),
+                            _mm256_load_si256((const __m256i*)(y + i)));
+      _mm256_store_si256((__m256i*)(x + i), v);
+    }
+#endif
+    for (; i < m; ++i) x[i] = apply<op>(x[i], y[i]);
+    return *this;
+  }
+
+  void trim() {
+    if (n % W) data()[words() - 1] &= (word(1) << (n % W)) - 1;
+  }
+
+  std::size_t n;
+  std::vector<Block> blocks;
+};
@@ -1,4 +1,3 @@
-
 // 0-index based, support
 // 1. range ai+=d*i^j [0<=j<=AK]
 // 2. maintaining ai*i^j [0<=j<=QK]
@@ -6,16 +5,12 @@ template <typename T, int AK = 0, int QK = 0>
 class FenwickTreeRangeAddRangeSum {
  public:
   FenwickTreeRangeAddRangeSum(int n_)
-      : n(n_),
-        delta(AK + 1, std::vector<T>(n)),
-        tree(AK + 1, std::vector(QK + 1, std::vector<T>(n))),
-        power_sum(AK + QK + 1, std::vector<T>(n + 1)) {
+      : n(n_), cells(n_), power_sum(n_ + 1) {
     std::vector<T> power(n + 1, 1);
     for (int k = 0; k <= AK + QK; ++k) {
       T sum = 0;
-      dbg(k, AK, QK);
       for (int i = 0; i <= n; ++i) {
-        power_sum[k][i] = sum;
+        power_sum[i][k] = sum;
         sum += power[i];
         power[i] *= i;
       }
@@ -26,38 +21,35 @@ class FenwickTreeRangeAddRangeSum {
   // O(klogn)
   void suffixAdd(int x, T v, int ak = 0) {
     assert(0 <= ak && ak <= AK);
+    std::array<T, QK + 1> w;
+    for (int qk = 0; qk <= QK; ++qk) w[qk] = v * power_sum[x][ak + qk];
     for (int i = x + 1; i <= n; i += i & -i) {
-      delta[ak][i - 1] += v;
-      for (int qk = 0; qk <= QK; ++qk) {
-        tree[ak][qk][i - 1] += v * power_sum[ak + qk][x];
-      }
+      Cell& c = cells[i - 1];
+      c.delta[ak] += v;
+      for (int qk = 0; qk <= QK; ++qk) c.tree[ak][qk] += w[qk];
     }
   }
 
   void suffixAdd(int x, std::vector<T> cof) {
     assert(cof.size() <= AK + 1);
-    for (int i = x + 1; i <= n; i += i & -i) {
-      for (int ak = 0; ak < cof.size(); ++ak) {
-        delta[ak][i - 1] += cof[ak];
-        for (int qk = 0; qk <= QK; ++qk) {
-          tree[ak][qk][i - 1] += cof[ak] * power_sum[ak + qk][x];
-        }
+    Cell d{};
+    for (int ak = 0; ak < cof.size(); ++ak) {
+      d.delta[ak] = cof[ak];
+      for (int qk = 0; qk <= QK; ++qk) {
+        d.tree[ak][qk] = cof[ak] * power_sum[x][ak + qk];
       }
     }
+    for (int i = x + 1; i <= n; i += i & -i) cells[i - 1] += d;
   }
 
   // \sum[i=0...x] ai^k
-  // O(k^2logn)
+  // O(k^2+klogn)
   std::vector<T> prefixSum(int x) {
+    Cell acc = prefixCell(x);
     std::vector<T> res(QK + 1);
     for (int qk = 0; qk <= QK; ++qk) {
       for (int ak = 0; ak <= AK; ++ak) {
-        auto L = T(), R = T();
-        for (int i = x + 1; i > 0; i -= i & -i) {
-          L += delta[ak][i - 1];
-          R += tree[ak][qk][i - 1];
-        }
-        res[qk] += L * power_sum[ak + qk][x + 1] - R;
+        res[qk] += acc.delta[ak] * power_sum[x + 1][ak + qk] - acc.tree[ak][qk];
       }
     }
     return res;
@@ -65,14 +57,10 @@ class FenwickTreeRangeAddRangeSum {
 
   T prefixSum(int x, int qk) {
     assert(0 <= qk && qk <= QK);
+    Cell acc = prefixCell(x);
     auto res = T();
     for (int ak = 0; ak <= AK; ++ak) {
-      auto L = T(), R = T();
-      for (int i = x + 1; i > 0; i -= i & -i) {
-        L += delta[ak][i - 1];
-        R += tree[ak][qk][i - 1];
-      }
-      res += L * power_sum[ak + qk][x + 1] - R;
+      res += acc.delta[ak] * power_sum[x + 1][ak + qk] - acc.tree[ak][qk];
     }
     return res;
   }
@@ -92,8 +80,28 @@ class FenwickTreeRangeAddRangeSum {
   }
 
  private:
+  // all coefficients of one fenwick node, so a single walk touches them
+  // together; the loops over AK/QK have compile-time bounds and get unrolled.
+  struct Cell {
+    std::array<T, AK + 1> delta;
+    std::array<std::array<T, QK + 1>, AK + 1> tree;
+
+    Cell& operator+=(const Cell& c) {
+      for (int ak = 0; ak <= AK; ++ak) {
+        delta[ak] += c.delta[ak];
+        for (int qk = 0; qk <= QK; ++qk) tree[ak][qk] += c.tree[ak][qk];
+      }
+      return *this;
+    }
+  };
+
+  Cell prefixCell(int x) {
+    Cell acc{};
+    for (int i = x + 1; i > 0; i -= i & -i) acc += cells[i - 1];
+    return acc;
+  }
+
   int n;
-  std::vector<std::vector<T>> delta;
-  std::vector<std::vector<std::vector<T>>> tree;
-  std::vector<std::vector<T>> power_sum;
-};
\ No newline at end of file
+  std::vector<Cell> cells;
+  std::vector<std::array<T, AK + QK + 1>> power_sum;
+};
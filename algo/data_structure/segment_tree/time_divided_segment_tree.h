@@ -1,102 +1,119 @@
-#include <bits/stdc++.h>
-
-#ifdef ZAYIN
-#include "dbg/dbg.h"
-#else
-#define dbg(...)
-#endif
-
-struct rollbackable_dsu {
-  const int n;
-  std::vector<int> fa;
-  std::vector<int> sz;
+// requires rollbackable_dsu.h
+// Offline dynamic connectivity: edges are added and removed over time, and
+// queries ask whether two vertices are connected, or how many components
+// there are, at their time.
+// Every edge is alive during a range of queries and is put on the O(logq)
+// nodes of a segment tree over the queries covering that range. A dfs over
+// the tree merges the edges of a node when entering it and rolls them back
+// when leaving it, so solve is O(n + q + mlogqlogn).
+// The edges of all nodes are kept in one CSR array, and the dfs uses an
+// explicit stack.
+class offline_dynamic_connectivity {
+ public:
+  offline_dynamic_connectivity(int n_) : n(n_) {}
 
-  int global_id;
-  std::vector<int> id;
-  std::vector<std::vector<std::pair<int*, int>>> ops;
-  rollbackable_dsu(int n_)
-      : n(n_), fa(n_, -1), sz(n_, 1), id(n_), global_id(n_) {
-    for (int i = 0; i < n_; ++i) id[i] = i;
+  void add_edge(int u, int v) {
+    if (u > v) std::swap(u, v);
+    alive[{u, v}].push_back(edges.size());
+    edges.push_back({u, v, (int)queries.size(), -1});
   }
 
-  int find(int i) {
-    while (~fa[i]) i = fa[i];
-    return i;
+  // removes the latest added copy of the edge, which should be alive
+  void remove_edge(int u, int v) {
+    if (u > v) std::swap(u, v);
+    auto it = alive.find({u, v});
+    assert(it != alive.end() && it->second.size());
+    edges[it->second.back()].r = queries.size();
+    it->second.pop_back();
+    if (it->second.empty()) alive.erase(it);
   }
-  int component_id(int u) { return id[find(u)]; }
-  bool merge(int u, int v) {
-    ops.push_back({});
-    int fu = find(u), fv = find(v);
-    if (fu == fv) return false;
-    if (sz[fu] < sz[fv]) std::swap(fu, fv);
-    auto& version = ops.back();
-    version.emplace_back(&sz[fu], sz[fu]);
-    version.emplace_back(&fa[fv], fa[fv]);
-    version.emplace_back(&id[fu], id[fu]);
-    sz[fu] += sz[fv];
-    fa[fv] = fu;
-    id[fu] = global_id++;
-    return true;
-  }
-  void rollback() {
-    for (auto [ptr, val] : ops.back()) {
-      *ptr = val;
-    }
-    ops.pop_back();
+
+  // whether u and v are connected now, returns the id of the query
+  int query(int u, int v) {
+    queries.emplace_back(u, v);
+    return queries.size() - 1;
   }
-};
 
-typedef std::pair<int, int> Edge;
+  // the number of components now, returns the id of the query
+  int query_components() {
+    queries.emplace_back(-1, -1);
+    return queries.size() - 1;
+  }
 
-struct segment_tree {
- public:
-  segment_tree(int n_) {
-    for (n = 1; n < n_; n <<= 1) {
-    }
-    tree.resize(n << 1);
+  // answers in query order: 0/1 for query, the count for query_components
+  std::vector<int> solve() {
+    return solve([](int, rollbackable_dsu&) {});
   }
 
-  void add(int a, int b, const Edge& e) {
-    std::function<void(int, int, int)> dfs = [&](int k, int l, int r) {
-      if (l > b || r < a) return;
-      if (a <= l && r <= b) {
-        tree[k].push_back(e);
-        return;
+  // also calls leaf(i, dsu) for every query i, with dsu holding the edges
+  // alive at its time, e.g. to aggregate something per leaf
+  template <class Leaf>
+  std::vector<int> solve(Leaf&& leaf) {
+    int q = queries.size();
+    std::vector<int> res(q);
+    if (!q) return res;
+    int size = 1;
+    while (size < q) size <<= 1;
+    // node k covers leaves 2k and 2k+1, leaf i is node size+i
+    std::vector<int> start(2 * size + 1), list;
+    auto cover = [&](int l, int r, auto&& f) {
+      for (l += size, r += size; l < r; l >>= 1, r >>= 1) {
+        if (l & 1) f(l++);
+        if (r & 1) f(--r);
       }
-      int mid = (l + r) >> 1;
-      dfs(k << 1, l, mid);
-      dfs(k << 1 | 1, mid + 1, r);
     };
-    dfs(1, 0, n - 1);
-  }
-
-  int n;
-  std::vector<std::vector<Edge>> tree;
-};
-
-int main() {
-  std::ios::sync_with_stdio(false);
-  std::cin.tie(nullptr);
-  std::cout.tie(nullptr);
-
-  rollbackable_dsu dsu(n);
-  std::function<void(int, int, int)> dfs = [&](int k, int l, int r) {
-    for (auto [u, v] : sgt.tree[k]) {
-      int idu = dsu.component_id(u), idv = dsu.component_id(v);
-      if (!dsu.merge(u, v)) continue;
-      int newid = dsu.component_id(u);
+    for (auto& e : edges) {
+      if (e.l < (~e.r ? e.r : q)) {
+        cover(e.l, ~e.r ? e.r : q, [&](int k) { ++start[k + 1]; });
+      }
     }
-    if (l == r) {
-      key[dsu.component_id(0)] = true;
-    } else {
-      int mid = (l + r) >> 1;
-      dfs(k << 1, l, mid);
-      dfs(k << 1 | 1, mid + 1, r);
+    for (int k = 0; k < 2 * size; ++k) start[k + 1] += start[k];
+    list.resize(start[2 * size]);
+    std::vector<int> pos(start.begin(), start.end() - 1);
+    for (int i = 0; i < edges.size(); ++i) {
+      auto& e = edges[i];
+      if (e.l < (~e.r ? e.r : q)) {
+        cover(e.l, ~e.r ? e.r : q, [&](int k) { list[pos[k]++] = i; });
+      }
     }
-    for (auto e : sgt.tree[k]) {
-      dsu.rollback();
+
+    rollbackable_dsu dsu(n);
+    // {k, version}: enter k, or leave it rolling back to version if k<0
+    std::vector<std::pair<int, int>> stk = {{1, 0}};
+    while (stk.size()) {
+      auto [k, version] = stk.back();
+      stk.pop_back();
+      if (k < 0) {
+        dsu.rollback(version);
+        continue;
+      }
+      if (k >= size && k - size >= q) continue;
+      stk.emplace_back(-k, dsu.version());
+      for (int i = start[k]; i < start[k + 1]; ++i) {
+        dsu.merge(edges[list[i]].u, edges[list[i]].v);
+      }
+      if (k >= size) {
+        int i = k - size;
+        auto [u, v] = queries[i];
+        res[i] = ~u ? dsu.is_in_same_set(u, v) : dsu.components();
+        leaf(i, dsu);
+      } else {
+        stk.emplace_back(2 * k + 1, 0);
+        stk.emplace_back(2 * k, 0);
+      }
     }
+    return res;
+  }
+
+ private:
+  struct edge {
+    // alive for queries [l,r), r=-1 if never removed
+    int u, v, l, r;
   };
 
-  return 0;
-}
\ No newline at end of file
+  const int n;
+  std::vector<edge> edges;
+  std::map<std::pair<int, int>, std::vector<int>> alive;
+  // {-1,-1} for query_components
+  std::vector<std::pair<int, int>> queries;
+};
@@ -0,0 +1,142 @@
+// requires euler_tour_sequence.h
+// O(n) preprocessing and O(1) lca/dis: range minimum of depth over seq, using
+// a sparse table over blocks of 64 and a monotone-stack bitmask inside
+// blocks.
+// O(nlogn) preprocessing and O(1) level_ancestor: ladder decomposition
+// (long paths extended upward by their length) plus jump pointers from
+// leaves.
+struct EulerTourLCA : public EulerTourSeq {
+  EulerTourLCA(int n) : EulerTourSeq(n) {}
+
+  void init(int rt) {
+    EulerTourSeq::init(rt);
+    build_rmq();
+    build_ladder();
+  }
+
+  int lca(int u, int v) {
+    int l = in[u], r = in[v];
+    if (l > r) std::swap(l, r);
+    return seq[argmin(l, r)];
+  }
+
+  int dis(int u, int v) { return dep[u] + dep[v] - 2 * dep[lca(u, v)]; }
+
+  // the k-th ancestor of u, -1 if there is no such one
+  int level_ancestor(int u, int k) {
+    if (k > dep[u]) return -1;
+    if (!k) return u;
+    int leaf = leaf_of[u];
+    k += dep[path_bottom[leaf]] - dep[u];
+    int j = std::__lg(k);
+    int w = jump[j * leaf_count + leaf];
+    return ladder[ladder_pos[w] - (k - (1 << j))];
+  }
+
+ private:
+  static constexpr int B = 64;
+
+  void build_rmq() {
+    int m = seq.size(), blocks = (m + B - 1) / B;
+    depth.resize(m);
+    for (int i = 0; i < m; ++i) depth[i] = dep[seq[i]];
+    mask.resize(m);
+    for (int b = 0; b < blocks; ++b) {
+      int stk[B], top = 0;
+      uint64_t cur = 0;
+      for (int i = b * B; i < std::min(m, (b + 1) * B); ++i) {
+        for (; top && depth[stk[top - 1]] >= depth[i]; --top) {
+          cur ^= uint64_t(1) << (stk[top - 1] - b * B);
+        }
+        stk[top++] = i;
+        cur |= uint64_t(1) << (i - b * B);
+        mask[i] = cur;
+      }
+    }
+    int levels = std::__lg(blocks) + 1;
+    table.assign(levels, std::vector<int>(blocks));
+    for (int b = 0; b < blocks; ++b) {
+      table[0][b] = in_block(b * B, std::min(m, (b + 1) * B) - 1);
+    }
+    for (int j = 1; j < levels; ++j) {
+      for (int b = 0; b + (1 << j) <= blocks; ++b) {
+        table[j][b] = better(table[j - 1][b], table[j - 1][b + (1 << (j - 1))]);
+      }
+    }
+  }
+
+  int better(int i, int j) { return depth[j] < depth[i] ? j : i; }
+
+  // l, r in the same block
+  int in_block(int l, int r) {
+    return l / B * B + __builtin_ctzll(mask[r] >> (l % B) << (l % B));
+  }
+
+  int argmin(int l, int r) {
+    int bl = l / B, br = r / B;
+    if (bl == br) return in_block(l, r);
+    int res = better(in_block(l, bl * B + B - 1), in_block(br * B, r));
+    if (bl + 1 < br) {
+      int j = std::__lg(br - bl - 1);
+      res = better(res, better(table[j][bl + 1], table[j][br - (1 << j)]));
+    }
+    return res;
+  }
+
+  void build_ladder() {
+    std::vector<int> pre, height(n, 1), long_son(n, -1);
+    pre.reserve(n);
+    for (int i = 0; i < seq.size(); ++i) {
+      if (in[seq[i]] == i) pre.push_back(seq[i]);
+    }
+    for (int i = pre.size() - 1; i > 0; --i) {
+      int u = pre[i], p = fa[u];
+      if (height[u] + 1 > height[p]) {
+        height[p] = height[u] + 1;
+        long_son[p] = u;
+      }
+    }
+
+    leaf_of.assign(n, -1);
+    ladder_pos.assign(n, -1);
+    ladder.clear();
+    path_bottom.clear();
+    for (int top : pre) {
+      if (~fa[top] && long_son[fa[top]] == top) continue;
+      int len = height[top], leaf = path_bottom.size();
+      std::vector<int> up;
+      for (int u = fa[top]; ~u && up.size() < len; u = fa[u]) up.push_back(u);
+      ladder.insert(ladder.end(), up.rbegin(), up.rend());
+      for (int u = top;; u = long_son[u]) {
+        leaf_of[u] = leaf;
+        ladder_pos[u] = ladder.size();
+        ladder.push_back(u);
+        if (!~long_son[u]) {
+          path_bottom.push_back(u);
+          break;
+        }
+      }
+    }
+
+    // jump[j*leaf_count+i]: the 2^j-th ancestor of path_bottom[i]
+    leaf_count = path_bottom.size();
+    int levels = std::__lg(std::max(1, height[pre[0]] - 1)) + 1;
+    jump.assign(levels * leaf_count, -1);
+    for (int i = 0; i < leaf_count; ++i) jump[i] = fa[path_bottom[i]];
+    for (int j = 1; j < levels; ++j) {
+      for (int i = 0; i < leaf_count; ++i) {
+        int x = jump[(j - 1) * leaf_count + i];
+        if (~x && dep[x] >= (1 << (j - 1))) {
+          jump[j * leaf_count + i] = ladder[ladder_pos[x] - (1 << (j - 1))];
+        }
+      }
+    }
+  }
+
+  std::vector<int> depth;
+  std::vector<uint64_t> mask;
+  std::vector<std::vector<int>> table;
+
+  int leaf_count;
+  std::vector<int> leaf_of, path_bottom, ladder_pos, ladder, jump;
+};
@@ -7,22 +7,28 @@ struct EulerTourSeq {
   }
 
   void init(int rt) {
-    std::function<void(int)> dfs = [&](int u) {
-      if (~fa[u]) {
-        G[u].erase(std::find(G[u].begin(), G[u].end(), fa[u]));
-      }
-      in[u] = out[u] = seq.size();
-      seq.push_back(u);
-      for (int v : G[u]) {
+    std::vector<int> it(n), stk = {rt};
+    in[rt] = out[rt] = seq.size();
+    seq.push_back(rt);
+    while (stk.size()) {
+      int u = stk.back();
+      if (it[u] < G[u].size()) {
+        int v = G[u][it[u]++];
         fa[v] = u;
         dep[v] = dep[u] + 1;
-        dfs(v);
-        size[u] += size[v];
-        out[u] = seq.size();
-        seq.push_back(u);
+        G[v].erase(std::find(G[v].begin(), G[v].end(), u));
+        in[v] = out[v] = seq.size();
+        seq.push_back(v);
+        stk.push_back(v);
+      } else {
+        stk.pop_back();
+        if (stk.empty()) break;
+        int p = stk.back();
+        size[p] += size[u];
+        out[p] = seq.size();
+        seq.push_back(p);
       }
-    };
-    dfs(rt);
+    }
   }
 
   int n;
@@ -7,49 +7,70 @@ struct HeavyLightDecomposition {
         dep(n_),
         in(n_),
         out(n_),
-        G(n_) {}
-  void addEdge(int u, int v) {
-    G[u].push_back(v);
-    G[v].push_back(u);
-  }
+        seq(n_),
+        chain(n_) {}
+  void addEdge(int u, int v) { edges.emplace_back(u, v); }
 
+  // O(n), no recursion
   void init(int rt) {
-    std::function<void(int)> dfs1 = [&](int u) {
-      if (~fa[u]) {
-        G[u].erase(std::find(G[u].begin(), G[u].end(), fa[u]));
-      }
-      for (int v : G[u]) {
+    std::vector<int> start(n + 1), adj(edges.size() * 2);
+    for (auto [u, v] : edges) ++start[u], ++start[v];
+    for (int i = 0; i < n; ++i) start[i + 1] += start[i];
+    for (auto [u, v] : edges) adj[--start[u]] = v, adj[--start[v]] = u;
+
+    std::vector<int> order = {rt}, heavy(n, -1);
+    order.reserve(n);
+    fa[rt] = -1;
+    dep[rt] = 0;
+    for (int i = 0; i < order.size(); ++i) {
+      int u = order[i];
+      size[u] = 1;
+      for (int j = start[u]; j < start[u + 1]; ++j) {
+        int v = adj[j];
+        if (v == fa[u]) continue;
         fa[v] = u;
         dep[v] = dep[u] + 1;
-        dfs1(v);
-        size[u] += size[v];
-      }
-      std::sort(G[u].begin(), G[u].end(),
-                [&](int i, int j) { return size[i] > size[j]; });
-    };
-    std::function<void(int)> dfs2 = [&](int u) {
-      in[u] = seq.size();
-      seq.push_back(u);
-      for (int v : G[u]) {
-        if (v == G[u].front())
-          top[v] = top[u];
-        else
-          top[v] = v;
-        dfs2(v);
+        order.push_back(v);
       }
-      out[u] = seq.size() - 1;
-    };
-    dfs1(rt);
+    }
+    for (int i = order.size() - 1; i > 0; --i) {
+      int u = order[i], p = fa[u];
+      size[p] += size[u];
+      if (!~heavy[p] || size[heavy[p]] < size[u]) heavy[p] = u;
+    }
+
+    // heavy son is pushed last so that it is visited right after its father
+    std::vector<int>& stk = order;
+    stk.assign(1, rt);
     top[rt] = rt;
-    dfs2(rt);
+    for (int timestamp = 0; stk.size();) {
+      int u = stk.back();
+      stk.pop_back();
+      in[u] = timestamp;
+      out[u] = timestamp + size[u] - 1;
+      seq[timestamp++] = u;
+      for (int j = start[u]; j < start[u + 1]; ++j) {
+        int v = adj[j];
+        if (v == fa[u] || v == heavy[u]) continue;
+        top[v] = v;
+        stk.push_back(v);
+      }
+      if (~heavy[u]) {
+        top[heavy[u]] = top[u];
+        stk.push_back(heavy[u]);
+      }
+    }
+    for (int u = 0; u < n; ++u) {
+      chain[in[u]] = {in[top[u]], ~fa[u] ? in[fa[u]] : -1, dep[u]};
+    }
   }
 
   int lca(int u, int v) {
-    while (top[u] != top[v]) {
-      if (dep[top[u]] < dep[top[v]]) std::swap(u, v);
-      u = fa[top[u]];
+    for (u = in[u], v = in[v]; chain[u].top != chain[v].top;) {
+      if (chain[u].top < chain[v].top) std::swap(u, v);
+      u = chain[chain[u].top].fa;
     }
-    return dep[u] < dep[v] ? u : v;
+    return seq[std::min(u, v)];
   }
 
   // is u ancester of v
@@ -69,9 +90,9 @@ struct HeavyLightDecomposition {
 
   int kthAncester(int u, int k) {
     if (dep[u] < k) return -1;
-    int d = dep[u] - k;
-    while (dep[top[u]] > d) u = fa[top[u]];
-    return seq[in[u] + d - dep[u]];
+    int d = dep[u] - k, p = in[u];
+    while (chain[chain[p].top].dep > d) p = chain[chain[p].top].fa;
+    return seq[p + d - chain[p].dep];
   }
 
   std::optional<std::pair<int, int>> pathIntersection(int u1, int v1, int u2,
@@ -124,9 +145,15 @@ struct HeavyLightDecomposition {
     return kthAncester(u, dis_u_lca + dis_v_lca - k);
   }
 
+  // indexed by position in seq, all of top/fa are positions as well
+  struct Chain {
+    int top, fa, dep;
+  };
+
   int n;
   std::vector<int> fa, top;
-  std::vector<int> in, out, seq;
   std::vector<int> size, dep;
-  std::vector<std::vector<int>> G;
+  std::vector<int> in, out, seq;
+  std::vector<Chain> chain;
+  std::vector<std::pair<int, int>> edges;
 };
\ No newline at end of file
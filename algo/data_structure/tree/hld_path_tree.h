@@ -0,0 +1,64 @@
+// requires heavy_light_decomposition.h, lazy_segment_tree.h
+// Info needs reverse() as LazyReversibleInfo in lazy_reversible_treap.h,
+// so that path_query is ordered for non-commutative Info.
+// path_apply/path_query O(log^2n), subtree_apply/subtree_query O(logn).
+template <typename Info, typename Tag>
+class hld_path_tree {
+ public:
+  // hld should be initialized, a is indexed by vertex
+  hld_path_tree(const HeavyLightDecomposition& hld_, const std::vector<Info>& a)
+      : hld(hld_), tree(by_seq(hld_, a)) {}
+  hld_path_tree(const HeavyLightDecomposition& hld_)
+      : hld(hld_), tree(hld_.n) {}
+
+  void change(int u, const Info& v) { tree.change(hld.in[u], v); }
+
+  void path_apply(int u, int v, const Tag& t) {
+    const auto &top = hld.top, &in = hld.in;
+    for (; top[u] != top[v]; u = hld.fa[top[u]]) {
+      if (hld.dep[top[u]] < hld.dep[top[v]]) std::swap(u, v);
+      tree.apply(in[top[u]], in[u], t);
+    }
+    tree.apply(std::min(in[u], in[v]), std::max(in[u], in[v]), t);
+  }
+
+  // info of the path in order from u to v
+  Info path_query(int u, int v) {
+    const auto &top = hld.top, &in = hld.in;
+    Info lhs, rhs;
+    while (top[u] != top[v]) {
+      if (hld.dep[top[u]] >= hld.dep[top[v]]) {
+        Info seg = tree.composite(in[top[u]], in[u]);
+        seg.reverse();
+        lhs = lhs + seg;
+        u = hld.fa[top[u]];
+      } else {
+        rhs = tree.composite(in[top[v]], in[v]) + rhs;
+        v = hld.fa[top[v]];
+      }
+    }
+    if (in[u] > in[v]) {
+      Info seg = tree.composite(in[v], in[u]);
+      seg.reverse();
+      return lhs + seg + rhs;
+    }
+    return lhs + tree.composite(in[u], in[v]) + rhs;
+  }
+
+  void subtree_apply(int u, const Tag& t) {
+    tree.apply(hld.in[u], hld.out[u], t);
+  }
+
+  Info subtree_query(int u) { return tree.composite(hld.in[u], hld.out[u]); }
+
+ private:
+  static std::vector<Info> by_seq(const HeavyLightDecomposition& hld,
+                                  const std::vector<Info>& a) {
+    std::vector<Info> res(hld.n);
+    for (int i = 0; i < hld.n; ++i) res[i] = a[hld.seq[i]];
+    return res;
+  }
+
+  const HeavyLightDecomposition& hld;
+  lazy_segment_tree<Info, Tag> tree;
+};
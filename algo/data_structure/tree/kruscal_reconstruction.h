@@ -1,19 +1,122 @@
-heavy_light_decomposition tree_small(n);
-disjoint_set_union dsu_small(n);
-for (int i = n - 1; i >= 0; --i)
-  for (int j : G[i]) {
-    if (j < i) continue;
-    tree_small.add_edge(i, dsu_small.find(j));
-    dsu_small.merge(i, j);
+// requires dsu.h, euler_tour_lca.h
+// Kruskal reconstruction tree: the leaves are the vertices [0,n), and every
+// edge joining two components in Kruskal order (increasing weight) becomes
+// a new node whose sons are the two components, so weights never decrease
+// going up. Components still apart at the end hang below a root of weight
+// inf.
+// build is O(mlogm) for the sort plus O(m α(n) + nlogn).
+// bottleneck(u,v): the largest weight on the min-bottleneck path between u
+// and v, the weight of their lca, O(1).
+// reachable(u,w): the vertices reachable from u by edges of weight <= w,
+// the leaves below the highest ancestor of u with weight <= w, found by
+// binary search over level_ancestor in O(logn).
+template <typename T>
+struct KruskalReconstructionTree {
+  static constexpr T inf = std::numeric_limits<T>::max();
+
+  int n, root = -1;
+  // nodes [0,n) are the vertices, weight is lowest() for them, node n+i is
+  // made by the i-th merge. order[lo[u]..hi[u]): the vertices below u.
+  std::vector<int> fa, order, lo, hi;
+  std::vector<T> weight;
+
+  KruskalReconstructionTree(int n) : n(n) {}
+
+  void addEdge(int u, int v, T w) { edges.push_back({w, u, v}); }
+
+  void build() {
+    std::sort(edges.begin(), edges.end(),
+              [](const Edge& a, const Edge& b) { return a.w < b.w; });
+    fa.assign(2 * n, -1);
+    weight.assign(2 * n, std::numeric_limits<T>::lowest());
+    // node[r]: the tree node of the component whose dsu root is r
+    std::vector<int> node(n);
+    std::iota(node.begin(), node.end(), 0);
+    disjoint_set_union dsu(n);
+    int m = n;
+    auto link = [&](int a, int b, T w) {
+      fa[a] = fa[b] = m;
+      weight[m] = w;
+      return m++;
+    };
+    for (auto [w, u, v] : edges) {
+      int ru = dsu.find(u), rv = dsu.find(v);
+      if (ru == rv) continue;
+      int a = node[ru], b = node[rv];
+      dsu.merge(ru, rv);
+      node[dsu.find(ru)] = link(a, b, w);
+      if (m == 2 * n - 1) break;
+    }
+    std::vector<int>().swap(node);
+    if (m < 2 * n - 1) {
+      // several components, the new root gets all of them as sons
+      root = m++;
+      virtual_root = true;
+      weight[root] = inf;
+      for (int u = 0; u < root; ++u) {
+        if (!~fa[u]) fa[u] = root;
+      }
+    } else {
+      root = m - 1;
+      virtual_root = false;
+    }
+    fa.resize(m);
+    weight.resize(m);
+
+    // sons are created before their father
+    std::vector<int> cnt(m, 1);
+    for (int u = n; u < m; ++u) cnt[u] = 0;
+    for (int u = 0; u < root; ++u) cnt[fa[u]] += cnt[u];
+    lo.assign(m, 0);
+    hi.assign(m, 0);
+    // next[u]: where the next son of u starts
+    std::vector<int> next(m);
+    for (int u = m - 1; u >= 0; --u) {
+      if (u != root) lo[u] = next[fa[u]], next[fa[u]] += cnt[u];
+      hi[u] = lo[u] + cnt[u];
+      next[u] = lo[u];
+    }
+    order.resize(n);
+    for (int u = 0; u < n; ++u) order[lo[u]] = u;
+
+    tree = std::make_unique<EulerTourLCA>(m);
+    for (int u = 0; u < m; ++u) {
+      if (u != root) tree->add_edge(fa[u], u);
+    }
+    tree->init(root);
   }
-tree_small.init(0);
-
-heavy_light_decomposition tree_big(n);
-disjoint_set_union dsu_big(n);
-for (int i = 0; i < n; ++i)
-  for (int j : G[i]) {
-    if (j > i) continue;
-    tree_big.add_edge(i, dsu_big.find(j));
-    dsu_big.merge(i, j);
+
+  // lowest() if u==v, inf if they are not connected
+  T bottleneck(int u, int v) { return weight[tree->lca(u, v)]; }
+
+  // the highest ancestor of u (u itself included) with weight <= w, never
+  // the inf root joining several components
+  int ancestor(int u, T w) {
+    int l = 0, r = tree->dep[u] - virtual_root;
+    while (l < r) {
+      int mid = (l + r + 1) >> 1;
+      if (weight[tree->level_ancestor(u, mid)] <= w) {
+        l = mid;
+      } else {
+        r = mid - 1;
+      }
+    }
+    return tree->level_ancestor(u, l);
+  }
+
+  std::span<const int> reachable(int u, T w) {
+    int a = ancestor(u, w);
+    return std::span<const int>(order).subspan(lo[a], hi[a] - lo[a]);
   }
-tree_big.init(n - 1);
\ No newline at end of file
+
+ private:
+  struct Edge {
+    T w;
+    int u, v;
+  };
+
+  std::vector<Edge> edges;
+  std::unique_ptr<EulerTourLCA> tree;
+  // whether root is the inf node added for a disconnected graph
+  bool virtual_root = false;
+};
@@ -0,0 +1,177 @@
+// LazyReversibleInfo/LazyTag as in lazy_reversible_treap.h, all operations
+// amortized O(logn), vertices 0-index based.
+// (a+b)+c=a+(b+c)
+// f(a+b)=f(a)+f(b)
+template <typename LazyReversibleInfo, typename LazyTag>
+class LinkCutTree {
+ public:
+  LinkCutTree(int n_) : n(n_), t(n_ + 1) {}
+  LinkCutTree(const std::vector<LazyReversibleInfo>& a)
+      : LinkCutTree(a.size()) {
+    for (int i = 0; i < n; ++i) t[i + 1].val = t[i + 1].sum = a[i];
+  }
+
+  // make u the root of its tree
+  void makeRoot(int u) { makeRootNode(u + 1); }
+
+  int findRoot(int u) { return findRootNode(u + 1) - 1; }
+
+  bool connected(int u, int v) { return findRoot(u) == findRoot(v); }
+
+  // returns false if u and v are already connected
+  bool link(int u, int v) {
+    int x = u + 1, y = v + 1;
+    makeRootNode(x);
+    if (findRootNode(y) == x) return false;
+    t[x].fa = y;
+    return true;
+  }
+
+  // returns false if there is no edge (u,v)
+  bool cut(int u, int v) {
+    int x = u + 1, y = v + 1;
+    makeRootNode(x);
+    if (findRootNode(y) != x || t[y].fa != x || t[y].ch[0]) return false;
+    t[x].ch[1] = t[y].fa = 0;
+    pull(x);
+    return true;
+  }
+
+  // lca with respect to the current root of the tree, call makeRoot to fix it.
+  // returns -1 if u and v are not connected
+  int lca(int u, int v) {
+    if (!connected(u, v)) return -1;
+    access(u + 1);
+    return access(v + 1) - 1;
+  }
+
+  LazyReversibleInfo get(int u) {
+    splayToTop(u + 1);
+    return t[u + 1].val;
+  }
+
+  void change(int u, const LazyReversibleInfo& v) {
+    int x = u + 1;
+    splayToTop(x);
+    t[x].val = v;
+    pull(x);
+  }
+
+  // u and v should be connected
+  void pathApply(int u, int v, const LazyTag& tag) {
+    apply(exposePath(u, v), tag);
+  }
+
+  // info of the path in order from u to v, u and v should be connected
+  LazyReversibleInfo pathQuery(int u, int v) {
+    return t[exposePath(u, v)].sum;
+  }
+
+ private:
+  struct Node {
+    int ch[2] = {0, 0}, fa = 0;
+    bool is_rev = false;
+    LazyTag tag;
+    LazyReversibleInfo val, sum;
+  };
+
+  bool isRoot(int x) { return t[t[x].fa].ch[0] != x && t[t[x].fa].ch[1] != x; }
+
+  void reverse(int x) {
+    if (!x) return;
+    std::swap(t[x].ch[0], t[x].ch[1]);
+    t[x].is_rev ^= true;
+    t[x].val.reverse();
+    t[x].sum.reverse();
+  }
+
+  void apply(int x, const LazyTag& tag) {
+    if (!x) return;
+    t[x].val.apply(tag);
+    t[x].sum.apply(tag);
+    t[x].tag.apply(tag);
+  }
+
+  void push(int x) {
+    if (t[x].is_rev) {
+      reverse(t[x].ch[0]);
+      reverse(t[x].ch[1]);
+      t[x].is_rev = false;
+    }
+    apply(t[x].ch[0], t[x].tag);
+    apply(t[x].ch[1], t[x].tag);
+    t[x].tag = LazyTag();
+  }
+
+  void pull(int x) {
+    t[x].sum = t[t[x].ch[0]].sum + t[x].val + t[t[x].ch[1]].sum;
+  }
+
+  void rotate(int x) {
+    int y = t[x].fa, z = t[y].fa, k = t[y].ch[1] == x;
+    if (!isRoot(y)) t[z].ch[t[z].ch[1] == y] = x;
+    t[x].fa = z;
+    t[y].ch[k] = t[x].ch[!k];
+    if (t[x].ch[!k]) t[t[x].ch[!k]].fa = y;
+    t[x].ch[!k] = y;
+    t[y].fa = x;
+    pull(y);
+    pull(x);
+  }
+
+  void splay(int x) {
+    stk.clear();
+    for (int y = x;; y = t[y].fa) {
+      stk.push_back(y);
+      if (isRoot(y)) break;
+    }
+    for (; stk.size(); stk.pop_back()) push(stk.back());
+    for (; !isRoot(x); rotate(x)) {
+      int y = t[x].fa;
+      if (!isRoot(y)) {
+        rotate((t[y].ch[1] == x) == (t[t[y].fa].ch[1] == y) ? y : x);
+      }
+    }
+  }
+
+  // returns the last splay root, which is the lca of x and the previously
+  // accessed vertex
+  int access(int x) {
+    int y = 0;
+    for (; x; y = x, x = t[x].fa) {
+      splay(x);
+      t[x].ch[1] = y;
+      pull(x);
+    }
+    return y;
+  }
+
+  void splayToTop(int x) {
+    access(x);
+    splay(x);
+  }
+
+  void makeRootNode(int x) {
+    splayToTop(x);
+    reverse(x);
+  }
+
+  int findRootNode(int x) {
+    splayToTop(x);
+    for (push(x); t[x].ch[0]; push(x)) x = t[x].ch[0];
+    splay(x);
+    return x;
+  }
+
+  // the splay root holding exactly the path u-v
+  int exposePath(int u, int v) {
+    makeRootNode(u + 1);
+    splayToTop(v + 1);
+    return v + 1;
+  }
+
+  int n;
+  // t[0] is the null node, vertex u is t[u+1]
+  std::vector<Node> t;
+  std::vector<int> stk;
+};
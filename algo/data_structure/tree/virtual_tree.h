@@ -1,42 +1,47 @@
+// Tree needs in/out/dep and lca(u,v), e.g. EulerTourLCA for O(1) lca or
+// HeavyLightDecomposition.
+// build is O(klogk) with O(1) lca, and only touches buffers of size O(k).
+template <typename Tree>
 struct VirtualTree {
-  HeavyLightDecomposition* hld;
-  std::vector<bool> key_vert;
-  std::vector<int> involved_vert;
-  std::vector<std::vector<int>> T;
-  VirtualTree(HeavyLightDecomposition* hld)
-      : hld(hld), key_vert(hld->n), involved_vert(hld->n), T(hld->n) {}
+  Tree* tree;
+  // result of build, in dfs order with the root first:
+  // vert[i] is the vertex, fa[i] the index of its father in vert (-1 for the
+  // root), is_key[i] whether it is one of the given vertices
+  std::vector<int> vert, fa;
+  std::vector<char> is_key;
+  VirtualTree(Tree* tree) : tree(tree) {}
 
-  void build(std::vector<int> vert) {
-    std::sort(vert.begin(), vert.end(),
-              [&](int u, int v) { return hld->in[u] < hld->in[v]; });
-    std::vector<int> stk = {0};
-    auto pop_stk = [&]() {
-      int v = stk.back();
-      stk.pop_back();
-      involved_vert.push_back(v);
-      if (stk.size()) T[stk.back()].push_back(v);
-    };
-    for (int u : vert) {
-      key_vert[u] = true;
-      int p = hld->lca(u, stk.back());
-      if (stk.back() != p) {
-        while (stk.size() && hld->dep[stk.back()] > hld->dep[p]) pop_stk();
-        assert(stk.size());
-        T[p].push_back(T[stk.back()].back());
-        T[stk.back()].pop_back();
+  void build(const std::vector<int>& key_vert) {
+    auto by_in = [&](int u, int v) { return tree->in[u] < tree->in[v]; };
+    keys.assign(key_vert.begin(), key_vert.end());
+    std::sort(keys.begin(), keys.end(), by_in);
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    vert = keys;
+    for (int i = 1; i < keys.size(); ++i) {
+      vert.push_back(tree->lca(keys[i - 1], keys[i]));
+    }
+    std::sort(vert.begin(), vert.end(), by_in);
+    vert.erase(std::unique(vert.begin(), vert.end()), vert.end());
+
+    fa.resize(vert.size());
+    is_key.assign(vert.size(), false);
+    stk.clear();
+    for (int i = 0, j = 0; i < vert.size(); ++i) {
+      if (j < keys.size() && keys[j] == vert[i]) is_key[i] = true, ++j;
+      while (stk.size() && !is_ancestor(vert[stk.back()], vert[i])) {
+        stk.pop_back();
       }
-      if (stk.back() != p) stk.push_back(p);
-      if (stk.back() != u) stk.push_back(u);
+      fa[i] = stk.size() ? stk.back() : -1;
+      stk.push_back(i);
     }
-    while (stk.size()) pop_stk();
   }
 
-  // remeber to clear the info of involved verts
-  void clear() {
-    for (int u : involved_vert) {
-      T[u].clear();
-      key_vert[u] = false;
-    }
-    involved_vert.clear();
+  int size() const { return vert.size(); }
+
+ private:
+  bool is_ancestor(int u, int v) {
+    return tree->in[u] <= tree->in[v] && tree->in[v] <= tree->out[u];
   }
-};
\ No newline at end of file
+
+  std::vector<int> keys, stk;
+};
@@ -1,16 +1,15 @@
+// requires dynamic_bitset.h, SubsetSum::solve(pool) works with ThreadPool
+// in thread_pool.h
 namespace knapsack {
 
 // Computes all possible subset sums from 0 to m.
 // Runs in O(m sqrt m / w) if the sum of `v` is bounded by m, and O(m^2 / w)
 // otherwise.
-template <int LEN = 1 << 20>
 std::vector<int> possibleSubsetSum(int m, const std::vector<int>& v) {
-  if (LEN > 1 && 2 * m < LEN) return possibleSubsetSum<LEN / 2>(m, v);
-  assert(m < LEN);
   std::vector<int> freq(m + 1);
   for (int x : v)
     if (x <= m) ++freq[x];
-  std::bitset<LEN> bits;
+  DynamicBitset bits(m + 1);
   std::vector<int> res = {0};
   bits.set(0);
   for (int x = 1; x <= m; ++x) {
@@ -19,10 +18,136 @@ std::vector<int> possibleSubsetSum(int m, const std::vector<int>& v) {
       freq[x] -= 2 * d;
       if (2 * x <= m) freq[2 * x] += d;
     }
-    while (freq[x]--) bits |= bits << x;
+    while (freq[x]--) bits.shiftOr(x);
     if (bits[x]) res.push_back(x);
   }
   return res;
 }
 
+// Reachable sums in [0,m] of items that can be used at most count times each
+// (count<0: any number of times), with recovery of the used items.
+// Both kinds are split into steps bits|=bits<<(k*w) sharing one kernel:
+// k=1,2,4,... up to count (the last step takes the rest), or while k*w<=m.
+// solve is O(steps*m/w), and may split every step by words across threads,
+// double-buffered since a step reads words lower than those it writes.
+// With checkpoint=K, the bitset before every K-th step is kept, and witness
+// recomputes K steps at a time from them, so it needs O((steps/K+K)m/w)
+// memory instead of O(steps*m/w). K around sqrt(steps) is the best.
+class SubsetSum {
+ public:
+  SubsetSum(int m, int checkpoint = 0)
+      : m(m), checkpoint(checkpoint), bits(m + 1) {}
+
+  // returns the id of the item
+  int addItem(int w, int count = 1) {
+    assert(w > 0);
+    items.emplace_back(w, count);
+    return items.size() - 1;
+  }
+
+  void solve() {
+    run([&](int x) { bits.shiftOr(x); });
+  }
+
+  // works with ThreadPool in thread_pool.h, grain is in words
+  template <class Pool>
+  void solve(Pool& pool, int grain = 1 << 14) {
+    DynamicBitset next(m + 1);
+    run([&](int x) {
+      auto f = [&](int l, int r, int) {
+        std::copy(bits.data() + l, bits.data() + r, next.data() + l);
+        next.orShifted(bits, x, l, r);
+      };
+      pool.parallelFor(0, bits.words(), f, grain);
+      std::swap(bits, next);
+    });
+  }
+
+  bool reachable(int s) const { return 0 <= s && s <= m && bits[s]; }
+  const DynamicBitset& getBits() const { return bits; }
+
+  // times every item is used for each target, std::nullopt if the target is
+  // not reachable, needs checkpoint>0
+  std::vector<std::optional<std::vector<int>>> witness(
+      const std::vector<int>& targets) const {
+    assert(checkpoint > 0);
+    std::vector<std::optional<std::vector<int>>> res(targets.size());
+    // rest[i]: what is left of targets[i], reachable before the current step
+    std::vector<int> rest(targets.size(), -1);
+    for (int i = 0; i < targets.size(); ++i) {
+      if (!reachable(targets[i])) continue;
+      res[i].emplace(items.size());
+      rest[i] = targets[i];
+    }
+    // before[s-lo]: bitset before step s of the current segment
+    std::vector<DynamicBitset> before;
+    for (int j = (int)snapshots.size() - 1; j >= 0; --j) {
+      int lo = j * checkpoint;
+      int hi = std::min<int>(lo + checkpoint, steps.size());
+      before.resize(hi - lo);
+      before[0] = snapshots[j];
+      for (int s = lo + 1; s < hi; ++s) {
+        before[s - lo] = before[s - lo - 1];
+        before[s - lo].shiftOr(shift(s - 1));
+      }
+      for (int s = hi - 1; s >= lo; --s) {
+        for (int i = 0; i < targets.size(); ++i) {
+          if (rest[i] < 0 || before[s - lo][rest[i]]) continue;
+          rest[i] -= shift(s);
+          (*res[i])[steps[s].item] += steps[s].k;
+        }
+      }
+    }
+    for (int r : rest) assert(r <= 0);
+    return res;
+  }
+
+  std::optional<std::vector<int>> witness(int target) const {
+    return witness(std::vector<int>{target})[0];
+  }
+
+ private:
+  struct Step {
+    int item, k;
+  };
+
+  int shift(int s) const { return steps[s].k * items[steps[s].item].first; }
+
+  void buildSteps() {
+    steps.clear();
+    for (int i = 0; i < items.size(); ++i) {
+      auto [w, count] = items[i];
+      if (count < 0) {
+        for (long long k = 1; k * w <= m; k *= 2) steps.push_back({i, (int)k});
+        continue;
+      }
+      for (int k = 1; count > 0; k *= 2) {
+        int t = std::min(k, count);
+        if ((long long)t * w <= m) steps.push_back({i, t});
+        count -= t;
+      }
+    }
+  }
+
+  // shift_or(x): bits|=bits<<x
+  template <class ShiftOr>
+  void run(ShiftOr&& shift_or) {
+    buildSteps();
+    bits.reset();
+    bits.set(0);
+    snapshots.clear();
+    for (int s = 0; s < steps.size(); ++s) {
+      if (checkpoint && s % checkpoint == 0) snapshots.push_back(bits);
+      shift_or(shift(s));
+    }
+  }
+
+  int m, checkpoint;
+  DynamicBitset bits;
+  // (weight, count)
+  std::vector<std::pair<int, int>> items;
+  std::vector<Step> steps;
+  std::vector<DynamicBitset> snapshots;
+};
+
 };  // namespace knapsack
\ No newline at end of file
@@ -1,42 +1,135 @@
-struct SegmentTree {
-  SegmentTree(int n) : n(n) {
-    std::function<int(int, int)> build = [&](int l, int r) {
-      int k = size();
-      ls.emplace_back(-1);
-      rs.emplace_back(-1);
-      if (l == r) return k;
-      int mid = (l + r) >> 1;
-      ls[k] = build(l, mid);
-      rs[k] = build(mid + 1, r);
-      return k;
-    };
-    build(0, n - 1);
+// Graph on vertices [0,n) with edges between ranges of vertices, built on
+// two bottom-up segment trees sharing the vertices as leaves. Tree node k
+// has children 2k and 2k+1, and leaf n+i is vertex i.
+// out tree, node k is n+k: k->2k, k->2k+1, reaches every vertex in range.
+// in tree, node k is 2n+k: 2k->k, 2k+1->k, reached from every vertex in
+// range.
+// Tree edges have weight 0 and are never stored, only added edges are, in
+// CSR built before the first search after addEdge. [a,b]->[c,d] costs
+// O(logn) edges, through a new node when both sides need several tree
+// nodes.
+template <typename T = int>
+struct SegmentTreeGraph {
+  static constexpr T inf = std::numeric_limits<T>::max();
+
+  SegmentTreeGraph(int n) : n(n), nodes(3 * n) {}
+
+  int size() const { return nodes; }
+
+  // every vertex in [a,b] to every vertex in [c,d] with weight w
+  void addEdge(int a, int b, int c, int d, T w) {
+    assert(0 <= a && a <= b && b < n && 0 <= c && c <= d && d < n);
+    lhs.clear();
+    rhs.clear();
+    range(a, b, 2 * n, lhs);
+    range(c, d, n, rhs);
+    if (lhs.size() > 1 && rhs.size() > 1) {
+      int m = nodes++;
+      for (int u : lhs) edges.push_back({u, m, w});
+      for (int v : rhs) edges.push_back({m, v, 0});
+      return;
+    }
+    for (int u : lhs) {
+      for (int v : rhs) edges.push_back({u, v, w});
+    }
+  }
+  void addEdge(int u, int v, T w) { addEdge(u, u, v, v, w); }
+
+  // distances from s, dis[i] for vertex i, weights should be 0 or 1
+  void bfs01(int s) {
+    init(s);
+    std::deque<std::pair<T, int>> q = {{0, s}};
+    while (q.size()) {
+      auto [d, u] = q.front();
+      q.pop_front();
+      if (dis[u] < d) continue;
+      relax(u, [&](int v, T w) {
+        assert(w == 0 || w == 1);
+        if (w) {
+          q.emplace_back(dis[v], v);
+        } else {
+          q.emplace_front(dis[v], v);
+        }
+      });
+    }
+  }
+
+  // distances from s, dis[i] for vertex i, weights should be nonnegative
+  void dijkstra(int s) {
+    init(s);
+    std::priority_queue<std::pair<T, int>, std::vector<std::pair<T, int>>,
+                        std::greater<>>
+        q;
+    q.emplace(0, s);
+    while (q.size()) {
+      auto [d, u] = q.top();
+      q.pop();
+      if (dis[u] < d) continue;
+      relax(u, [&](int v, T) { q.emplace(dis[v], v); });
+    }
+  }
+
+  int n;
+  // also holds the tree nodes and the nodes made by addEdge after [0,n)
+  std::vector<T> dis;
+
+ private:
+  struct Edge {
+    int from, to;
+    T weight;
   };
 
-  int size() { return ls.size(); }
+  // the node ids covering [a,b] in the tree whose node k is base+k
+  void range(int a, int b, int base, std::vector<int>& res) const {
+    auto id = [&](int k) { return k >= n ? k - n : base + k; };
+    for (a += n, b += n + 1; a < b; a >>= 1, b >>= 1) {
+      if (a & 1) res.push_back(id(a++));
+      if (b & 1) res.push_back(id(--b));
+    }
+  }
 
-  int point(int i) {
-    std::vector<int> res = range(i, i);
-    assert(res.size() == 1);
-    return res[0];
+  void init(int s) {
+    if (built != edges.size() || start.size() != nodes + 1) {
+      built = edges.size();
+      start.assign(nodes + 1, 0);
+      for (auto& e : edges) ++start[e.from + 1];
+      for (int u = 0; u < nodes; ++u) start[u + 1] += start[u];
+      adj.resize(edges.size());
+      std::vector<int> pos(start.begin(), start.end() - 1);
+      for (auto& e : edges) adj[pos[e.from]++] = {e.to, e.weight};
+    }
+    dis.assign(nodes, inf);
+    dis[s] = 0;
   }
 
-  std::vector<int> range(int a, int b) {
-    std::vector<int> res;
-    std::function<void(int, int, int)> find = [&](int k, int l, int r) {
-      if (a > r || l > b) return;
-      if (a <= l && r <= b) {
-        res.push_back(k);
-        return;
-      }
-      int mid = (l + r) >> 1;
-      find(ls[k], l, mid);
-      find(rs[k], mid + 1, r);
+  // improves the successors of u, push(v,w) is called for every improved v
+  // reached by an edge of weight w
+  template <class Push>
+  void relax(int u, Push&& push) {
+    auto go = [&](int v, T w) {
+      if (dis[v] <= dis[u] + w) return;
+      dis[v] = dis[u] + w;
+      push(v, w);
     };
-    find(0, 0, n - 1);
-    return res;
+    if (u < n) {
+      // the in tree parent of leaf n+u
+      if ((n + u) >> 1) go(2 * n + ((n + u) >> 1), 0);
+    } else if (u < 2 * n) {
+      for (int c = 2 * (u - n); c < 2 * (u - n) + 2; ++c) {
+        go(c >= n ? c - n : n + c, 0);
+      }
+    } else if (u < 3 * n) {
+      if ((u - 2 * n) >> 1) go(2 * n + ((u - 2 * n) >> 1), 0);
+    }
+    for (int i = start[u]; i < start[u + 1]; ++i) {
+      go(adj[i].first, adj[i].second);
+    }
   }
 
-  int n;
-  std::vector<int> ls, rs;
-};
\ No newline at end of file
+  int nodes;
+  std::vector<Edge> edges;
+  std::size_t built = 0;
+  std::vector<int> start;
+  std::vector<std::pair<int, T>> adj;
+  std::vector<int> lhs, rhs;
+};
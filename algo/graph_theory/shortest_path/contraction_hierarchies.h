@@ -0,0 +1,338 @@
+// requires weighted_graph.h
+// Contraction hierarchies for repeated s-t queries on a directed graph with
+// nonnegative weights.
+// Vertices are contracted one by one by priority 2*edge difference (shortcuts
+// added - arcs removed) + contracted neighbours + depth, recomputed for the
+// neighbours of every contracted vertex with witness searches limited to
+// simulate_limit settled vertices. Contracting x adds a shortcut u->w for
+// every u->x->w, unless a witness search from u avoiding x, limited to
+// witness_limit settled vertices, finds a path that is not longer.
+// A query runs dijkstra from s over arcs going up in rank and from t over
+// reversed arcs going up in rank, with stall on demand, so it only settles
+// a small part of the graph. Shortcuts remember the two arcs they replace,
+// so that path() can unpack them into original edges.
+template <typename T>
+struct contraction_hierarchies {
+  static constexpr T inf = std::numeric_limits<T>::max();
+
+  struct arc {
+    int from, to;
+    T weight;
+    // the arcs from->mid and mid->to a shortcut replaces, -1 if original
+    int lo, hi;
+  };
+
+  int n = 0;
+  // contraction order, higher is contracted later
+  std::vector<int> rank;
+  std::vector<arc> arcs;
+  // arcs from u to higher rank are up[up_start[u]..up_start[u+1]), arcs from
+  // higher rank into u are down[down_start[u]..down_start[u+1])
+  std::vector<int> up_start, up, down_start, down;
+
+  contraction_hierarchies() {}
+  contraction_hierarchies(const weighted_graph<weighted_edge<T>>& g,
+                          int witness_limit = 500, int simulate_limit = 5) {
+    n = g.n;
+    contract(g, witness_limit, simulate_limit);
+    build_search_graph();
+    prepare();
+  }
+
+  // distance from s to t, inf if t is not reachable
+  T query(int s, int t) {
+    for (int u : touched[0]) dis[0][u] = inf, from[0][u] = -1;
+    for (int u : touched[1]) dis[1][u] = inf, from[1][u] = -1;
+    touched[0].assign(1, s);
+    touched[1].assign(1, t);
+    dis[0][s] = dis[1][t] = 0;
+    heap[0].assign(1, {0, s});
+    heap[1].assign(1, {0, t});
+    T best = inf;
+    meet = -1;
+    while (heap[0].size() || heap[1].size()) {
+      int k = heap[0].empty() ||
+              (heap[1].size() && heap[1][0].first < heap[0][0].first);
+      auto [d, u] = pop(heap[k]);
+      // nothing this side settles from now on can improve best
+      if (d >= best) {
+        heap[k].clear();
+        continue;
+      }
+      if (dis[k][u] < d) continue;
+      if (dis[!k][u] != inf && d + dis[!k][u] < best) {
+        best = d + dis[!k][u];
+        meet = u;
+      }
+      auto& start = k ? down_start : up_start;
+      auto& list = k ? down : up;
+      if (stalled(k, u, d)) continue;
+      for (int i = start[u]; i < start[u + 1]; ++i) {
+        const arc& a = arcs[list[i]];
+        int v = k ? a.from : a.to;
+        if (dis[k][v] <= d + a.weight) continue;
+        if (dis[k][v] == inf) touched[k].push_back(v);
+        dis[k][v] = d + a.weight;
+        from[k][v] = list[i];
+        push(heap[k], {dis[k][v], v});
+      }
+    }
+    return best;
+  }
+
+  // the shortest path found by the last query in original vertices, empty
+  // if there is none
+  std::vector<int> path() const {
+    if (!~meet) return {};
+    // arcs of the path in order, still packed
+    std::vector<int> packed;
+    for (int u = meet; ~from[0][u]; u = arcs[from[0][u]].from) {
+      packed.push_back(from[0][u]);
+    }
+    std::reverse(packed.begin(), packed.end());
+    for (int u = meet; ~from[1][u]; u = arcs[from[1][u]].to) {
+      packed.push_back(from[1][u]);
+    }
+    std::vector<int> res = {meet}, stk;
+    if (packed.size()) res[0] = arcs[packed[0]].from;
+    for (int a : packed) {
+      for (stk.assign(1, a); stk.size();) {
+        int b = stk.back();
+        stk.pop_back();
+        if (~arcs[b].lo) {
+          stk.push_back(arcs[b].hi);
+          stk.push_back(arcs[b].lo);
+        } else {
+          res.push_back(arcs[b].to);
+        }
+      }
+    }
+    return res;
+  }
+
+  // binary, T should be trivially copyable
+  void save(std::ostream& os) const {
+    auto put = [&](const auto& v) {
+      std::size_t size = v.size();
+      os.write((const char*)&size, sizeof(size));
+      os.write((const char*)v.data(), size * sizeof(v[0]));
+    };
+    os.write((const char*)&n, sizeof(n));
+    put(rank), put(arcs), put(up_start), put(up), put(down_start), put(down);
+  }
+
+  static contraction_hierarchies load(std::istream& is) {
+    contraction_hierarchies res;
+    auto get = [&](auto& v) {
+      std::size_t size;
+      is.read((char*)&size, sizeof(size));
+      v.resize(size);
+      is.read((char*)v.data(), size * sizeof(v[0]));
+    };
+    is.read((char*)&res.n, sizeof(res.n));
+    get(res.rank), get(res.arcs), get(res.up_start), get(res.up);
+    get(res.down_start), get(res.down);
+    res.prepare();
+    return res;
+  }
+
+ private:
+  using item = std::pair<T, int>;
+
+  static void push(std::vector<item>& q, item x) {
+    q.push_back(x);
+    std::push_heap(q.begin(), q.end(), std::greater<item>());
+  }
+  static item pop(std::vector<item>& q) {
+    std::pop_heap(q.begin(), q.end(), std::greater<item>());
+    item res = q.back();
+    q.pop_back();
+    return res;
+  }
+
+  // stall on demand: u reached by side k with distance d is not worth
+  // expanding if a higher vertex already gives a shorter distance to it,
+  // through an arc the search itself does not use
+  bool stalled(int k, int u, T d) const {
+    auto& start = k ? up_start : down_start;
+    auto& list = k ? up : down;
+    for (int i = start[u]; i < start[u + 1]; ++i) {
+      const arc& a = arcs[list[i]];
+      T dv = dis[k][k ? a.to : a.from];
+      if (dv != inf && dv + a.weight < d) return true;
+    }
+    return false;
+  }
+
+  void contract(const weighted_graph<weighted_edge<T>>& g, int limit,
+                int simulate_limit) {
+    // live arcs between uncontracted vertices
+    std::vector<std::vector<int>> out(n), in(n);
+    auto add_arc = [&](int u, int v, T w, int lo, int hi) {
+      out[u].push_back(arcs.size());
+      in[v].push_back(arcs.size());
+      arcs.push_back({u, v, w, lo, hi});
+    };
+    for (int u = 0; u < n; ++u) {
+      auto add = [&](const weighted_edge<T>& e) {
+        if (e.to != u) add_arc(u, e.to, e.weight, -1, -1);
+      };
+      if (g.frozen()) {
+        for (int i = g.start[u]; i < g.start[u + 1]; ++i) add(g.edges[i]);
+      } else {
+        for (int i : g.g[u]) add(g.edges[i]);
+      }
+    }
+
+    std::vector<T> wdis(n, inf);
+    // target[w]==stamp: w is a target of the current shortcuts call
+    std::vector<int> wtouched, target(n, -1);
+    int stamp = 0;
+    std::vector<item> q;
+    // dijkstra from s avoiding x, until the targets of x are settled, up to
+    // max_settled settled vertices or distance bound
+    auto witness = [&](int s, int x, int targets, T bound, int max_settled) {
+      for (int u : wtouched) wdis[u] = inf;
+      wtouched.assign(1, s);
+      wdis[s] = 0;
+      q.assign(1, {0, s});
+      for (int settled = 0; q.size() && settled < max_settled;) {
+        auto [d, u] = pop(q);
+        if (d > bound) break;
+        if (wdis[u] < d) continue;
+        if (target[u] == stamp && !--targets) break;
+        ++settled;
+        for (int i : out[u]) {
+          auto [_, v, w, lo, hi] = arcs[i];
+          if (v == x || wdis[v] <= d + w) continue;
+          if (wdis[v] == inf) wtouched.push_back(v);
+          push(q, {wdis[v] = d + w, v});
+        }
+      }
+    };
+    // calls shortcut(in arc, out arc) for every shortcut contracting x needs
+    auto shortcuts = [&](int x, int max_settled, auto&& shortcut) {
+      int targets = 0;
+      ++stamp;
+      for (int b : out[x]) {
+        int w = arcs[b].to;
+        if (target[w] != stamp) target[w] = stamp, ++targets;
+      }
+      for (int a : in[x]) {
+        int u = arcs[a].from;
+        T bound = 0;
+        for (int b : out[x]) {
+          if (arcs[b].to != u) {
+            bound = std::max(bound, arcs[a].weight + arcs[b].weight);
+          }
+        }
+        witness(u, x, targets, bound, max_settled);
+        for (int b : out[x]) {
+          int w = arcs[b].to;
+          if (w != u && wdis[w] > arcs[a].weight + arcs[b].weight) {
+            shortcut(a, b);
+          }
+        }
+      }
+    };
+
+    std::vector<int> contracted_neighbours(n), depth(n);
+    auto priority = [&](int x) {
+      int added = 0;
+      shortcuts(x, simulate_limit, [&](int, int) { ++added; });
+      return 2 * (added - int(in[x].size() + out[x].size())) +
+             contracted_neighbours[x] + depth[x];
+    };
+    auto drop = [&](std::vector<int>& list, int x, bool head) {
+      auto it = std::remove_if(list.begin(), list.end(), [&](int i) {
+        return (head ? arcs[i].to : arcs[i].from) == x;
+      });
+      list.erase(it, list.end());
+    };
+
+    // entries of order not matching prio are outdated
+    std::vector<int> prio(n), neighbours;
+    std::priority_queue<item, std::vector<item>, std::greater<item>> order;
+    for (int x = 0; x < n; ++x) order.push({prio[x] = priority(x), x});
+    rank.assign(n, -1);
+    for (int r = 0; order.size();) {
+      auto [p, x] = order.top();
+      order.pop();
+      if (~rank[x] || p != prio[x]) continue;
+      rank[x] = r++;
+      shortcuts(x, limit, [&](int a, int b) {
+        int u = arcs[a].from, w = arcs[b].to;
+        T len = arcs[a].weight + arcs[b].weight;
+        // keep one arc u->w, the shorter one
+        for (int i : out[u]) {
+          if (arcs[i].to != w) continue;
+          if (len < arcs[i].weight) arcs[i] = {u, w, len, a, b};
+          return;
+        }
+        add_arc(u, w, len, a, b);
+      });
+      neighbours.clear();
+      for (int a : in[x]) {
+        drop(out[arcs[a].from], x, true);
+        neighbours.push_back(arcs[a].from);
+      }
+      for (int b : out[x]) {
+        drop(in[arcs[b].to], x, false);
+        neighbours.push_back(arcs[b].to);
+      }
+      std::vector<int>().swap(in[x]);
+      std::vector<int>().swap(out[x]);
+      std::sort(neighbours.begin(), neighbours.end());
+      neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+                       neighbours.end());
+      for (int v : neighbours) {
+        ++contracted_neighbours[v];
+        depth[v] = std::max(depth[v], depth[x] + 1);
+        order.push({prio[v] = priority(v), v});
+      }
+    }
+  }
+
+  void build_search_graph() {
+    up_start.assign(n + 1, 0);
+    down_start.assign(n + 1, 0);
+    for (auto& a : arcs) {
+      if (rank[a.from] < rank[a.to]) {
+        ++up_start[a.from + 1];
+      } else {
+        ++down_start[a.to + 1];
+      }
+    }
+    for (int u = 0; u < n; ++u) {
+      up_start[u + 1] += up_start[u];
+      down_start[u + 1] += down_start[u];
+    }
+    up.resize(up_start[n]);
+    down.resize(down_start[n]);
+    std::vector<int> up_pos(up_start.begin(), up_start.end() - 1);
+    std::vector<int> down_pos(down_start.begin(), down_start.end() - 1);
+    for (int i = 0; i < arcs.size(); ++i) {
+      if (rank[arcs[i].from] < rank[arcs[i].to]) {
+        up[up_pos[arcs[i].from]++] = i;
+      } else {
+        down[down_pos[arcs[i].to]++] = i;
+      }
+    }
+  }
+
+  void prepare() {
+    for (int k = 0; k < 2; ++k) {
+      dis[k].assign(n, inf);
+      from[k].assign(n, -1);
+      touched[k].clear();
+    }
+    meet = -1;
+  }
+
+  // [0]: search from s, [1]: search from t over reversed arcs
+  std::vector<T> dis[2];
+  // the arc each vertex is reached by
+  std::vector<int> from[2], touched[2];
+  std::vector<item> heap[2];
+  int meet = -1;
+};
@@ -0,0 +1,142 @@
+// requires weighted_graph.h, work(pool, ...) works with ThreadPool in
+// thread_pool.h
+// Parallel single source shortest paths, weights should be nonnegative.
+// Vertices are kept in buckets of width delta by distance. The current
+// bucket is settled by relaxing light edges (w<=delta) of its vertices in
+// parallel until it stops changing, then their heavy edges are relaxed once.
+// Distances are improved with an atomic min, every relaxation from a final
+// distance also happens here, so dis is bit-identical to dijkstra even for
+// floating point weights.
+// Smaller delta means less wasted relaxations but more phases.
+template <typename T,
+          typename std::enable_if_t<std::is_arithmetic<T>::value, int> = 0>
+struct delta_stepping : public weighted_graph<weighted_edge<T>> {
+  static constexpr T inf = std::numeric_limits<T>::max();
+
+  std::vector<T> dis;
+
+  delta_stepping(int n) : weighted_graph<weighted_edge<T>>(n), dis(n, inf) {}
+
+  // d is the bucket width delta, d<=0: max weight / average degree.
+  // grain: vertices per task
+  template <class Pool>
+  void work(Pool& pool, int vs, T d = 0, int grain = 256) {
+    init(d);
+    dis.assign(this->n, inf);
+    dis[vs] = 0;
+    updated.resize(pool.size());
+    std::size_t queued = 1;
+    buckets.assign(std::size_t(max_weight / delta) + 2, {});
+    buckets[0].push_back(vs);
+    for (long long i = 0; queued; ++i) {
+      auto& b = buckets[i % buckets.size()];
+      settled.clear();
+      ++settle_round;
+      while (b.size()) {
+        // vertices really in bucket i, without duplicates
+        queued -= b.size();
+        frontier.clear();
+        ++round;
+        for (int u : b) {
+          if (bucket(dis[u]) != i || mark[u] == round) continue;
+          mark[u] = round;
+          frontier.push_back(u);
+          if (settled_mark[u] != settle_round) {
+            settled_mark[u] = settle_round;
+            settled.push_back(u);
+          }
+        }
+        b.clear();
+        relax(pool, frontier, true, grain);
+        queued += collect();
+      }
+      relax(pool, settled, false, grain);
+      queued += collect();
+    }
+  }
+
+ private:
+  long long bucket(T d) const {
+    if constexpr (std::is_integral<T>::value) {
+      return d / delta;
+    } else {
+      return std::floor(d / delta);
+    }
+  }
+
+  // puts the light edges (w<=delta) of every vertex first
+  void init(T d) {
+    this->freeze();
+    auto& e = this->edges;
+    if (mid.empty()) {
+      max_weight = 0;
+      for (auto& x : e) max_weight = std::max(max_weight, x.weight);
+      mark.assign(this->n, 0);
+      settled_mark.assign(this->n, 0);
+    }
+    if (d <= 0) {
+      d = max_weight / std::max<T>(1, T(e.size()) / std::max(1, this->n));
+      if (d <= 0) d = 1;
+    }
+    if (mid.size() && d == delta) return;
+    delta = d;
+    mid.resize(this->n);
+    for (int u = 0; u < this->n; ++u) {
+      mid[u] = std::partition(e.begin() + this->start[u],
+                              e.begin() + this->start[u + 1],
+                              [&](auto& x) { return x.weight <= delta; }) -
+               e.begin();
+    }
+  }
+
+  // relaxes the light or heavy edges of vs in parallel, improved vertices
+  // are recorded per thread
+  template <class Pool>
+  void relax(Pool& pool, const std::vector<int>& vs, bool light, int grain) {
+    auto f = [&](int l, int r, int w) {
+      for (int k = l; k < r; ++k) {
+        int u = vs[k];
+        T du = std::atomic_ref<T>(dis[u]).load(std::memory_order_relaxed);
+        int first = light ? this->start[u] : mid[u];
+        int last = light ? mid[u] : this->start[u + 1];
+        for (int i = first; i < last; ++i) {
+          auto [v, weight] = this->edges[i];
+          T nd = du + weight;
+          std::atomic_ref<T> dv(dis[v]);
+          T cur = dv.load(std::memory_order_relaxed);
+          while (nd < cur) {
+            if (dv.compare_exchange_weak(cur, nd,
+                                         std::memory_order_relaxed)) {
+              updated[w].push_back(v);
+              break;
+            }
+          }
+        }
+      }
+    };
+    pool.parallelFor(0, vs.size(), f, grain);
+  }
+
+  // moves the improved vertices into their buckets
+  std::size_t collect() {
+    std::size_t res = 0;
+    for (auto& list : updated) {
+      for (int v : list) {
+        buckets[bucket(dis[v]) % buckets.size()].push_back(v);
+      }
+      res += list.size();
+      list.clear();
+    }
+    return res;
+  }
+
+  T delta = 0, max_weight = 0;
+  // light edges of u are edges[start[u]..mid[u])
+  std::vector<int> mid;
+  std::vector<std::vector<int>> buckets, updated;
+  std::vector<int> frontier, settled;
+  // mark[u]==round: u is in the frontier, settled_mark[u]==settle_round: u
+  // is settled in the current bucket
+  std::vector<long long> mark, settled_mark;
+  long long round = 0, settle_round = 0;
+};
@@ -1,36 +1,258 @@
+// Monotone priority queue for unsigned integer keys, every pushed key should
+// be at least the last popped one. Amortized O(logC) per element, where C is
+// the largest difference between a pushed key and the last popped one.
+template <typename K, typename V>
+struct radix_heap {
+  static_assert(std::is_unsigned<K>::value);
+  std::array<std::vector<std::pair<K, V>>, sizeof(K) * 8 + 1> buckets;
+  K last = 0;
+  std::size_t count = 0;
+
+  bool empty() const { return !count; }
+
+  void clear() {
+    for (auto& b : buckets) b.clear();
+    last = 0;
+    count = 0;
+  }
+
+  void push(K key, V v) {
+    assert(key >= last);
+    buckets[bucket(key)].emplace_back(key, v);
+    ++count;
+  }
+
+  std::pair<K, V> pop() {
+    if (buckets[0].empty()) {
+      int i = 1;
+      while (buckets[i].empty()) ++i;
+      last = std::min_element(buckets[i].begin(), buckets[i].end())->first;
+      for (auto& p : buckets[i]) buckets[bucket(p.first)].push_back(p);
+      buckets[i].clear();
+    }
+    --count;
+    auto res = buckets[0].back();
+    buckets[0].pop_back();
+    return res;
+  }
+
+ private:
+  int bucket(K key) const {
+    return key == last ? 0 : std::bit_width(key ^ last);
+  }
+};
+
+// work: binary heap, O(mlogm).
+// work_radix: radix heap, O(m+nlogC), T should be integral.
+// work_dial: Dial's C+1 cyclic buckets, O(m+n+max dis), T should be
+// integral, for small C.
+// C is the largest weight, weights should be nonnegative. The graph is
+// frozen into CSR by the first work.
+// Every work takes one or several sources, and stops as soon as vt is
+// popped if vt is given. dis/from/reachable are only reset on the vertices
+// touched by the previous call, so a query costs O(what it visits).
 template <typename T,
           typename std::enable_if_t<std::is_arithmetic<T>::value, int> = 0>
 struct dijkstra : public weighted_graph<weighted_edge<T>> {
   static constexpr T inf = std::numeric_limits<T>::max();
 
-  std::vector<T> dis, from;
+  std::vector<T> dis;
+  std::vector<int> from;
   std::vector<bool> reachable;
 
   dijkstra(int n)
-      : weighted_graph<weighted_edge<T>>(n), dis(n), from(n), reachable(n) {}
-
-  void work(int vs) {
-    struct item {
-      int u;
-      T d;
-      bool operator<(const item& I) const { return d > I.d; }
-    };
-    dis.assign(this->n, inf);
-    reachable.assign(this->n, false);
-    from.assign(this->n, -1);
-    std::priority_queue<item> q;
-    q.push({vs, dis[vs] = 0});
-    while (q.size()) {
-      auto [u, d] = q.top();
-      q.pop();
+      : weighted_graph<weighted_edge<T>>(n),
+        dis(n, inf),
+        from(n, -1),
+        reachable(n),
+        dis_rev(n, inf),
+        from_rev(n, -1) {}
+
+  void work(int vs, int vt = -1) { work(std::span<const int>(&vs, 1), vt); }
+  void work(std::span<const int> vs, int vt = -1) {
+    init(vs);
+    heap.clear();
+    for (int u : vs) push(heap, {0, u});
+    while (heap.size()) {
+      auto [d, u] = pop(heap);
       if (dis[u] < d) continue;
-      reachable[u] = true;
-      for (int i : this->g[u]) {
-        auto [v, w] = this->edges[i];
-        if (dis[v] <= dis[u] + w) continue;
-        from[v] = u;
-        q.push({v, dis[v] = dis[u] + w});
+      if (!relax(u, vt, [&](int v, T d) { push(heap, {d, v}); })) break;
+    }
+  }
+
+  void work_radix(int vs, int vt = -1) {
+    work_radix(std::span<const int>(&vs, 1), vt);
+  }
+  void work_radix(std::span<const int> vs, int vt = -1) {
+    static_assert(std::is_integral<T>::value);
+    init(vs);
+    radix.clear();
+    for (int u : vs) radix.push(0, u);
+    while (!radix.empty()) {
+      auto [d, u] = radix.pop();
+      if (dis[u] < T(d)) continue;
+      if (!relax(u, vt, [&](int v, T d) { radix.push(d, v); })) break;
+    }
+  }
+
+  void work_dial(int vs, int vt = -1) {
+    work_dial(std::span<const int>(&vs, 1), vt);
+  }
+  void work_dial(std::span<const int> vs, int vt = -1) {
+    static_assert(std::is_integral<T>::value);
+    init(vs);
+    if (buckets.empty()) {
+      T c = 0;
+      for (auto& e : this->edges) c = std::max(c, e.weight);
+      buckets.resize(c + 1);
+    }
+    // buckets[d%(c+1)]: vertices pushed with distance d, only distances in
+    // [cur,cur+c] can be pending
+    T c = buckets.size() - 1;
+    for (auto& b : buckets) b.clear();
+    buckets[0].assign(vs.begin(), vs.end());
+    std::size_t pending = vs.size();
+    for (T cur = 0; pending; ++cur) {
+      auto& b = buckets[cur % (c + 1)];
+      // zero weight edges may push into b while it is scanned
+      for (std::size_t i = 0; i < b.size(); ++i) {
+        int u = b[i];
+        --pending;
+        if (dis[u] != cur) continue;
+        bool go_on = relax(u, vt, [&](int v, T d) {
+          buckets[d % (c + 1)].push_back(v);
+          ++pending;
+        });
+        if (!go_on) return;
+      }
+      b.clear();
+    }
+  }
+
+  // distance from s to t, inf if t is not reachable. Bidirectional search
+  // with binary heaps over the graph and its reverse, dis/from are only
+  // meaningful for path() afterwards.
+  T query(int s, int t) {
+    init(std::span<const int>(&s, 1));
+    init_rev(t);
+    meet = s == t ? s : -1;
+    T best = s == t ? 0 : inf;
+    heap.assign(1, {0, s});
+    heap_rev.assign(1, {0, t});
+    // each side settles vertices in order, and the path through the
+    // meeting vertex can not be improved once the tops add up to best
+    while (heap.size() && heap_rev.size() &&
+           heap[0].first + heap_rev[0].first < best) {
+      bool forward = heap[0].first <= heap_rev[0].first;
+      auto& q = forward ? heap : heap_rev;
+      auto &d1 = forward ? dis : dis_rev, &d2 = forward ? dis_rev : dis;
+      auto& f1 = forward ? from : from_rev;
+      auto& start = forward ? this->start : start_rev;
+      auto& edges = forward ? this->edges : edges_rev;
+      auto [d, u] = pop(q);
+      if (d1[u] < d) continue;
+      for (int i = start[u]; i < start[u + 1]; ++i) {
+        auto [v, w] = edges[i];
+        if (d1[v] <= d + w) continue;
+        if (d1[v] == inf) (forward ? touched : touched_rev).push_back(v);
+        f1[v] = u;
+        push(q, {d1[v] = d + w, v});
+        if (d2[v] != inf && d1[v] + d2[v] < best) {
+          best = d1[v] + d2[v];
+          meet = v;
+        }
+      }
+    }
+    return best;
+  }
+
+  // the shortest path found by the last query, empty if there is none
+  std::vector<int> path() const {
+    std::vector<int> res;
+    if (!~meet) return res;
+    for (int u = meet; ~u; u = from[u]) res.push_back(u);
+    std::reverse(res.begin(), res.end());
+    for (int u = from_rev[meet]; ~u; u = from_rev[u]) res.push_back(u);
+    return res;
+  }
+
+ private:
+  using key_type = typename std::conditional_t<
+      std::is_integral<T>::value, std::make_unsigned<T>,
+      std::type_identity<unsigned>>::type;
+  using item = std::pair<T, int>;
+
+  static void push(std::vector<item>& q, item x) {
+    q.push_back(x);
+    std::push_heap(q.begin(), q.end(), std::greater<item>());
+  }
+  static item pop(std::vector<item>& q) {
+    std::pop_heap(q.begin(), q.end(), std::greater<item>());
+    item res = q.back();
+    q.pop_back();
+    return res;
+  }
+
+  void init(std::span<const int> vs) {
+    this->freeze();
+    for (int u : touched) {
+      dis[u] = inf;
+      from[u] = -1;
+      reachable[u] = false;
+    }
+    touched.assign(vs.begin(), vs.end());
+    for (int u : vs) dis[u] = 0;
+  }
+
+  // builds the reverse graph on first use
+  void init_rev(int vt) {
+    if (start_rev.empty()) {
+      start_rev.assign(this->n + 1, 0);
+      for (auto& e : this->edges) ++start_rev[e.to + 1];
+      for (int u = 0; u < this->n; ++u) start_rev[u + 1] += start_rev[u];
+      std::vector<int> pos(start_rev.begin(), start_rev.end() - 1);
+      edges_rev.resize(this->edges.size(), {0, T()});
+      for (int u = 0; u < this->n; ++u) {
+        for (int i = this->start[u]; i < this->start[u + 1]; ++i) {
+          auto [v, w] = this->edges[i];
+          edges_rev[pos[v]++] = {u, w};
+        }
       }
     }
+    for (int u : touched_rev) {
+      dis_rev[u] = inf;
+      from_rev[u] = -1;
+    }
+    touched_rev.assign(1, vt);
+    dis_rev[vt] = 0;
   }
-};
\ No newline at end of file
+
+  // u is popped with its final distance, push(v,d) queues v with d,
+  // returns false if the search should stop
+  template <typename Push>
+  bool relax(int u, int vt, Push&& push) {
+    reachable[u] = true;
+    if (u == vt) return false;
+    for (int i = this->start[u]; i < this->start[u + 1]; ++i) {
+      auto [v, w] = this->edges[i];
+      if (dis[v] <= dis[u] + w) continue;
+      if (dis[v] == inf) touched.push_back(v);
+      from[v] = u;
+      push(v, dis[v] = dis[u] + w);
+    }
+    return true;
+  }
+
+  // vertices whose dis is not inf
+  std::vector<int> touched, touched_rev;
+  std::vector<item> heap, heap_rev;
+  radix_heap<key_type, int> radix;
+  std::vector<std::vector<int>> buckets;
+
+  // reverse graph and the backward side of query
+  std::vector<int> start_rev;
+  std::vector<weighted_edge<T>> edges_rev;
+  std::vector<T> dis_rev;
+  std::vector<int> from_rev;
+  int meet = -1;
+};
@@ -1,45 +1,101 @@
+// O(n+m), no recursion, edges are kept in CSR form (start/adj)
 struct DirectionalTarjan {
-  DirectionalTarjan(int n_) : n(n_), dfn(n_), low(n_), G(n_) {}
+  DirectionalTarjan(int n_) : n(n_), dfn(n_), low(n_) {}
 
-  void addEdge(int u, int v) { G[u].push_back(v); }
+  void addEdge(int u, int v) { edges.emplace_back(u, v); }
 
+  // scc ids are in reverse topological order, i.e. bel[u]>=bel[v] for every
+  // edge u->v
   std::pair<int, std::vector<int>> getSCC() {
+    buildCSR();
     dfn.assign(n, -1);
     low.assign(n, -1);
     int timestamp = 0, bel_id = 0;
-    std::stack<int> stk;
+    std::vector<int> stk, path, it(start.begin(), start.end() - 1);
     std::vector<int> bel(n, -1);
-    std::function<void(int)> dfs = [&](int u) {
+    auto enter = [&](int u) {
       dfn[u] = low[u] = timestamp++;
-      stk.push(u);
-
-      for (int v : G[u]) {
-        if (!~dfn[v]) {
-          dfs(v);
-          low[u] = std::min(low[u], low[v]);
-        } else if (!~bel[v]) {
-          low[u] = std::min(low[u], dfn[v]);
+      stk.push_back(u);
+      path.push_back(u);
+    };
+    for (int i = 0; i < n; ++i) {
+      if (~dfn[i]) continue;
+      for (enter(i); path.size();) {
+        int u = path.back();
+        if (it[u] < start[u + 1]) {
+          int v = adj[it[u]++];
+          if (!~dfn[v]) {
+            enter(v);
+          } else if (!~bel[v]) {
+            low[u] = std::min(low[u], dfn[v]);
+          }
+          continue;
+        }
+        path.pop_back();
+        if (path.size()) low[path.back()] = std::min(low[path.back()], low[u]);
+        if (dfn[u] == low[u]) {
+          while (1) {
+            int v = stk.back();
+            bel[v] = bel_id;
+            stk.pop_back();
+            if (u == v) break;
+          }
+          ++bel_id;
         }
       }
+    }
+    return {bel_id, bel};
+  }
+
+  struct Condensation {
+    int n;
+    // scc ids are in topological order, i.e. bel[u]<=bel[v] for every edge
+    // u->v
+    std::vector<int> bel;
+    // edges between different scc without duplicates, out edges of scc c are
+    // adj[start[c]..start[c+1])
+    std::vector<int> start, adj;
+  };
 
-      if (dfn[u] == low[u]) {
-        while (1) {
-          int v = stk.top();
-          bel[v] = bel_id;
-          stk.pop();
-          if (u == v) break;
+  Condensation getCondensation() {
+    auto [cnt, bel] = getSCC();
+    for (int& b : bel) b = cnt - 1 - b;
+    std::vector<int> seq(n), pos(cnt + 1);
+    for (int u = 0; u < n; ++u) ++pos[bel[u] + 1];
+    for (int c = 0; c < cnt; ++c) pos[c + 1] += pos[c];
+    for (int u = 0; u < n; ++u) seq[pos[bel[u]]++] = u;
+
+    Condensation res{cnt, std::move(bel), std::vector<int>(cnt + 1), {}};
+    std::vector<int> last(cnt, -1);
+    for (int c = 0, i = 0; c < cnt; ++c) {
+      for (; i < n && res.bel[seq[i]] == c; ++i) {
+        int u = seq[i];
+        for (int j = start[u]; j < start[u + 1]; ++j) {
+          int d = res.bel[adj[j]];
+          if (d == c || last[d] == c) continue;
+          last[d] = c;
+          res.adj.push_back(d);
         }
-        ++bel_id;
-      }
-    };
-    for (int i = 0; i < n; ++i)
-      if (!~dfn[i]) {
-        dfs(i);
       }
-    return {bel_id, bel};
+      res.start[c + 1] = res.adj.size();
+    }
+    return res;
   }
 
   int n;
   std::vector<int> dfn, low;
-  std::vector<std::vector<int>> G;
+  std::vector<std::pair<int, int>> edges;
+  std::vector<int> start, adj;
+
+ protected:
+  void buildCSR() {
+    if (start.size() == n + 1 && adj.size() == edges.size()) return;
+    start.assign(n + 1, 0);
+    adj.resize(edges.size());
+    for (auto [u, v] : edges) ++start[u];
+    for (int i = 0; i < n; ++i) start[i + 1] += start[i];
+    for (int i = edges.size() - 1; i >= 0; --i) {
+      adj[--start[edges[i].first]] = edges[i].second;
+    }
+  }
 };
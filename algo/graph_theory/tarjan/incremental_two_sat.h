@@ -0,0 +1,128 @@
+// 2*i: false, 2*i+1: true, same as TwoSAT.
+// Keeps a solution of the clauses added so far. A clause violated by it is
+// repaired by making one of its literals true together with everything it
+// implies. Only literals that become true are visited (O(n+m) in the worst
+// case), and if both literals imply a contradiction the clause can not be
+// satisfied.
+// Assumptions are literals forced to be true until their batch is popped,
+// popping costs O(number of assumptions).
+struct IncrementalTwoSAT {
+  IncrementalTwoSAT(int n)
+      : n(n),
+        value(n),
+        head(2 * n, -1),
+        assumed(2 * n),
+        round(2 * n, -1),
+        failed_level(-1) {}
+
+  inline int T(int i) { return i << 1 | 1; }
+  inline int F(int i) { return i << 1; }
+  inline int node_id(int i, int v) {
+    assert(v == 0 || v == 1);
+    return i << 1 | v;
+  }
+  inline int var_id(int u) { return u >> 1; }
+  inline int opposite(int u) { return u ^ 1; }
+
+  bool isTrue(int u) const { return value[u >> 1] == (u & 1); }
+
+  // returns satisfiable()
+  bool addOr(int u, int v) {
+    addEdge(opposite(u), v);
+    addEdge(opposite(v), u);
+    if (!isTrue(u) && !isTrue(v) && !repair(u) && !repair(v)) {
+      pending.emplace_back(u, v);
+    }
+    return satisfiable();
+  }
+
+  // starts a new batch of assumptions
+  void push() { batches.push_back(assumptions.size()); }
+
+  // drops the assumptions since the matching push
+  void pop() {
+    assert(batches.size());
+    for (; assumptions.size() > batches.back(); assumptions.pop_back()) {
+      --assumed[assumptions.back()];
+    }
+    batches.pop_back();
+    if (failed_level > (int)batches.size()) failed_level = -1;
+    // clauses that failed because of the dropped assumptions
+    int k = 0;
+    for (auto [u, v] : pending) {
+      if (!isTrue(u) && !isTrue(v) && !repair(u) && !repair(v)) {
+        pending[k++] = {u, v};
+      }
+    }
+    pending.resize(k);
+  }
+
+  // forces u to be true in the current batch, returns satisfiable()
+  bool assume(int u) {
+    if (!isTrue(u) && !repair(u)) {
+      if (!~failed_level) failed_level = batches.size();
+      return false;
+    }
+    ++assumed[u];
+    assumptions.push_back(u);
+    return satisfiable();
+  }
+
+  bool satisfiable() const { return pending.empty() && !~failed_level; }
+
+  // valid if satisfiable()
+  std::vector<bool> getOneSolution() const {
+    return std::vector<bool>(value.begin(), value.end());
+  }
+
+  int n;
+
+ private:
+  void addEdge(int u, int v) {
+    to.push_back(v);
+    next.push_back(head[u]);
+    head[u] = to.size() - 1;
+  }
+
+  // u is false, makes u and everything it implies true, nothing is changed
+  // if that contradicts itself or an assumption
+  bool repair(int u) {
+    if (assumed[opposite(u)]) return false;
+    int cur = ++rounds;
+    trail.clear();
+    stk.assign(1, u);
+    round[u] = cur;
+    bool ok = true;
+    while (ok && stk.size()) {
+      int x = stk.back();
+      stk.pop_back();
+      value[x >> 1] = x & 1;
+      trail.push_back(x);
+      for (int e = head[x]; ~e; e = next[e]) {
+        int y = to[e];
+        if (isTrue(y) || round[y] == cur) continue;
+        if (assumed[opposite(y)] || round[opposite(y)] == cur) {
+          ok = false;
+          break;
+        }
+        round[y] = cur;
+        stk.push_back(y);
+      }
+    }
+    if (!ok) {
+      for (int x : trail) value[x >> 1] = !(x & 1);
+    }
+    return ok;
+  }
+
+  // value[i]: whether variable i is true in the current solution
+  std::vector<char> value;
+  // adjacency lists of the implication graph
+  std::vector<int> head, next, to;
+  // assumed[u]: number of active assumptions of u
+  std::vector<int> assumed, assumptions, batches;
+  std::vector<std::pair<int, int>> pending;
+  // round[u]==rounds: u is set during the current repair
+  std::vector<int> round, trail, stk;
+  int rounds = 0, failed_level;
+};
@@ -1,6 +1,7 @@
+// requires directional_tarjan.h, dynamic_bitset.h
 // 2*i: false, 2*i+1: true
 struct TwoSAT : public DirectionalTarjan {
-  TwoSAT(int n) : n(n), DirectionalTarjan(2 * n) {}
+  TwoSAT(int n) : DirectionalTarjan(2 * n), n(n) {}
 
   inline int T(int i) { return i << 1 | 1; }
   inline int F(int i) { return i << 1; }
@@ -29,32 +30,36 @@ struct TwoSAT : public DirectionalTarjan {
   }
 
   // find at most m solutions, O(mn^2/w)
-  template <int LEN = 1 << 20>
   std::vector<std::vector<bool>> getMultipleSolution(int m) {
-    if (LEN > 1 && 2 * n <= LEN / 2) return getMultipleSolution<LEN / 2>(m);
-    assert(2 * n <= LEN);
-    auto [bcnt, bel] = getSCC();
+    auto dag = getCondensation();
+    const auto& bel = dag.bel;
     for (int i = 0; i < n; ++i) {
       if (bel[T(i)] == bel[F(i)]) return {};
     }
-    std::vector<int> order(2 * n);
-    std::iota(order.begin(), order.end(), 0);
-    std::sort(order.begin(), order.end(),
-              [&](int u, int v) { return bel[u] < bel[v]; });
-    std::vector<std::bitset<LEN>> reachable(2 * n);
-    std::vector<std::bitset<LEN>> reachable_opposite(2 * n);
-
-    for (int u : order) {
-      for (int v : G[u]) reachable[u] |= reachable[v];
-      for (int v = 0; v < n * 2; ++v)
-        if (bel[u] == bel[v]) reachable[u].set(v);
-      for (int v = 0; v < n * 2; ++v) {
-        if (reachable[u][v]) reachable_opposite[u].set(opposite(v));
+    // literals implied by the literals of each scc, and their opposites
+    std::vector<DynamicBitset> reach(dag.n, DynamicBitset(2 * n));
+    std::vector<DynamicBitset> reach_opposite = reach;
+    for (int u = 0; u < 2 * n; ++u) reach[bel[u]].set(u);
+    for (int c = dag.n - 1; c >= 0; --c) {
+      for (int j = dag.start[c]; j < dag.start[c + 1]; ++j) {
+        reach[c] |= reach[dag.adj[j]];
+      }
+      // opposite literals are adjacent bits of the same word
+      const DynamicBitset::word even = 0x5555555555555555, *x = reach[c].data();
+      DynamicBitset::word* y = reach_opposite[c].data();
+      for (int i = 0; i < reach[c].words(); ++i) {
+        y[i] = (x[i] & even) << 1 | (x[i] >> 1 & even);
       }
     }
+    auto reachable = [&](int u) -> const DynamicBitset& {
+      return reach[bel[u]];
+    };
+    auto reachable_opposite = [&](int u) -> const DynamicBitset& {
+      return reach_opposite[bel[u]];
+    };
 
     std::vector<std::vector<bool>> res;
-    std::bitset<LEN> vised;
+    DynamicBitset vised(2 * n);
     std::function<bool(int)> dfs = [&](int i) {
       if (i == n) {
         res.emplace_back(n);
@@ -66,10 +71,10 @@ struct TwoSAT : public DirectionalTarjan {
         if (!dfs(i + 1)) return false;
       } else {
         auto test = [&](int u) {
-          if (!reachable_opposite[u][u] &&
-              (reachable_opposite[u] & vised).none()) {
-            std::bitset<LEN> backup = vised;
-            vised |= reachable[u];
+          if (!reachable_opposite(u)[u] &&
+              !reachable_opposite(u).intersects(vised)) {
+            DynamicBitset backup = vised;
+            vised |= reachable(u);
             if (!dfs(i + 1)) return false;
             vised = backup;
           }
@@ -1,23 +1,113 @@
+// schedule works with ThreadPool in thread_pool.h
+// The graph is either adjacency lists G, or CSR where the successors of u
+// are adj[start[u]..start[u+1]).
+// solve: a topological order, nullopt if there is a cycle. O(n+m).
+// layers: the same order split into antichains, layer i is
+// order[start[i]..start[i+1]) and holds the vertices whose longest path from
+// a source has i edges, so every layer only depends on the ones before it.
+// schedule: runs f(w, u) for every vertex u on a work stealing pool, as soon
+// as f has finished on all its predecessors, w is the worker running it.
+// Returns false if there is a cycle, f is not called on the vertices on or
+// after it.
 struct TopoSort {
+  struct Layers {
+    std::vector<int> order, start;
+  };
+
   static std::optional<std::vector<int>> solve(
       const std::vector<std::vector<int>>& G) {
-    std::vector<int> deg(G.size());
-    for (int i = 0; i < G.size(); ++i)
-      for (int j : G[i]) ++deg[j];
-    std::queue<int> q;
-    for (int i = 0; i < G.size(); ++i)
-      if (!deg[i]) q.push(i);
-    std::vector<int> seq;
-    while (q.size()) {
-      int i = q.front();
-      q.pop();
-      seq.push_back(i);
-      for (int j : G[i]) {
-        --deg[j];
-        if (!deg[j]) q.push(j);
+    auto res = layers(G);
+    if (!res) return std::nullopt;
+    return std::move(res->order);
+  }
+  static std::optional<std::vector<int>> solve(std::span<const int> start,
+                                               std::span<const int> adj) {
+    auto res = layers(start, adj);
+    if (!res) return std::nullopt;
+    return std::move(res->order);
+  }
+
+  static std::optional<Layers> layers(const std::vector<std::vector<int>>& G) {
+    return kahn(G.size(), [&](int u) -> auto& { return G[u]; });
+  }
+  static std::optional<Layers> layers(std::span<const int> start,
+                                      std::span<const int> adj) {
+    return kahn(start.size() - 1, [&](int u) {
+      return adj.subspan(start[u], start[u + 1] - start[u]);
+    });
+  }
+
+  template <class Pool, class F>
+  static bool schedule(Pool& pool, const std::vector<std::vector<int>>& G,
+                       F&& f) {
+    return run(pool, G.size(), [&](int u) -> auto& { return G[u]; }, f);
+  }
+  template <class Pool, class F>
+  static bool schedule(Pool& pool, std::span<const int> start,
+                       std::span<const int> adj, F&& f) {
+    auto succ = [&](int u) {
+      return adj.subspan(start[u], start[u + 1] - start[u]);
+    };
+    return run(pool, start.size() - 1, succ, f);
+  }
+
+ private:
+  // order doubles as the queue, and the vertices a layer releases are
+  // exactly the next layer
+  template <class Succ>
+  static std::optional<Layers> kahn(int n, Succ&& succ) {
+    std::vector<int> deg(n);
+    for (int u = 0; u < n; ++u) {
+      for (int v : succ(u)) ++deg[v];
+    }
+    Layers res;
+    res.order.reserve(n);
+    for (int u = 0; u < n; ++u) {
+      if (!deg[u]) res.order.push_back(u);
+    }
+    for (int l = 0; l < res.order.size();) {
+      res.start.push_back(l);
+      int r = res.order.size();
+      for (; l < r; ++l) {
+        for (int v : succ(res.order[l])) {
+          if (!--deg[v]) res.order.push_back(v);
+        }
       }
     }
-    if (seq.size() != G.size()) return std::nullopt;
-    return seq;
+    if (res.order.size() != n) return std::nullopt;
+    res.start.push_back(n);
+    return res;
+  }
+
+  template <class Pool, class Succ, class F>
+  static bool run(Pool& pool, int n, Succ&& succ, F& f) {
+    std::vector<std::atomic<int>> deg(n);
+    for (int u = 0; u < n; ++u) {
+      for (int v : succ(u)) deg[v].fetch_add(1, std::memory_order_relaxed);
+    }
+    std::vector<int> sources;
+    for (int u = 0; u < n; ++u) {
+      if (!deg[u].load(std::memory_order_relaxed)) sources.push_back(u);
+    }
+    std::atomic<int> finished = 0;
+    // runs u, keeps the last successor it releases for itself and spawns
+    // the others
+    std::function<void(int, int)> visit = [&](int w, int u) {
+      while (~u) {
+        f(w, u);
+        finished.fetch_add(1, std::memory_order_relaxed);
+        int next = -1;
+        for (int v : succ(u)) {
+          if (deg[v].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+          if (~next) pool.spawn(w, [&, next](int w) { visit(w, next); });
+          next = v;
+        }
+        u = next;
+      }
+    };
+    pool.run([&](int w) {
+      for (int u : sources) pool.spawn(w, [&, u](int w) { visit(w, u); });
+    });
+    return finished == n;
   }
-};
\ No newline at end of file
+};
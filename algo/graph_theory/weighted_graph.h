@@ -10,11 +10,31 @@ struct weighted_graph {
   const int n;
   std::vector<T> edges;
   std::vector<std::vector<int>> g;
+  // set by freeze: the out edges of u are edges[start[u]..start[u+1])
+  std::vector<int> start;
   weighted_graph(int n) : n(n), g(n) {}
 
   void add_edge(int u, T edge) {
-    assert(0 <= u && u < n);
+    assert(0 <= u && u < n && !frozen());
     g[u].push_back(edges.size());
     edges.push_back(edge);
   }
-};
\ No newline at end of file
+
+  bool frozen() const { return start.size(); }
+
+  // reorders edges by their source (CSR) and drops g, so that the out edges
+  // of a vertex are contiguous. Edge indices change, add_edge should not be
+  // called after.
+  void freeze() {
+    if (frozen()) return;
+    start.assign(n + 1, 0);
+    std::vector<T> csr;
+    csr.reserve(edges.size());
+    for (int u = 0; u < n; ++u) {
+      for (int i : g[u]) csr.push_back(edges[i]);
+      start[u + 1] = csr.size();
+    }
+    edges = std::move(csr);
+    std::vector<std::vector<int>>().swap(g);
+  }
+};
@@ -0,0 +1,117 @@
+// Work stealing thread pool. Every worker owns a deque of tasks, it takes
+// the newest task of its own deque and steals the oldest one of the others
+// when it runs out.
+// A task gets the id of the worker running it, which is in [0,size()) and
+// can index per-thread buffers, since a worker runs one task at a time.
+// Tasks should not block waiting for other tasks.
+class ThreadPool {
+ public:
+  using Task = std::function<void(int)>;
+
+  ThreadPool(int n = std::max(1u, std::thread::hardware_concurrency()))
+      : workers(n) {
+    for (int i = 0; i < n; ++i) threads.emplace_back([this, i] { loop(i); });
+  }
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex);
+      stop = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+  }
+
+  int size() const { return workers.size(); }
+
+  // runs root and everything it spawns, returns when all of them finished
+  void run(Task root) {
+    pending = 1;
+    push(0, std::move(root));
+    std::unique_lock lock(mutex);
+    done.wait(lock, [&] { return pending == 0; });
+  }
+
+  // called from a task running on worker w
+  void spawn(int w, Task task) {
+    ++pending;
+    push(w, std::move(task));
+  }
+
+  // f(l,r,w) on consecutive blocks covering [l,r), about grain elements each
+  template <class F>
+  void parallelFor(int l, int r, F&& f, int grain = 1) {
+    int blocks = std::min((r - l + grain - 1) / grain, size() * 4);
+    if (blocks <= 1) {
+      if (l < r) f(l, r, 0);
+      return;
+    }
+    run([&](int w) {
+      for (int i = 0; i < blocks; ++i) {
+        int lo = l + (long long)(r - l) * i / blocks;
+        int hi = l + (long long)(r - l) * (i + 1) / blocks;
+        spawn(w, [&f, lo, hi](int w) { f(lo, hi, w); });
+      }
+    });
+  }
+
+ private:
+  struct alignas(64) Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void push(int w, Task task) {
+    {
+      std::lock_guard lock(workers[w].mutex);
+      workers[w].tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard lock(mutex);
+      ++queued;
+    }
+    wake.notify_one();
+  }
+
+  bool pop(int w, Task& task) {
+    for (int i = 0; i < size(); ++i) {
+      Worker& v = workers[(w + i) % size()];
+      std::lock_guard lock(v.mutex);
+      if (v.tasks.empty()) continue;
+      if (i == 0) {
+        task = std::move(v.tasks.back());
+        v.tasks.pop_back();
+      } else {
+        task = std::move(v.tasks.front());
+        v.tasks.pop_front();
+      }
+      --queued;
+      return true;
+    }
+    return false;
+  }
+
+  void loop(int w) {
+    for (Task task;;) {
+      if (pop(w, task)) {
+        task(w);
+        task = nullptr;
+        if (--pending == 0) {
+          std::lock_guard lock(mutex);
+          done.notify_all();
+        }
+        continue;
+      }
+      std::unique_lock lock(mutex);
+      wake.wait(lock, [&] { return stop || queued > 0; });
+      if (stop) return;
+    }
+  }
+
+  std::vector<Worker> workers;
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable wake, done;
+  // queued: tasks in deques, pending: tasks spawned but not finished
+  std::atomic<int> queued = 0, pending = 0;
+  bool stop = false;
+};